@@ -39,6 +39,13 @@ LICENSE
 #include <xmmintrin.h>
 #endif
 
+/* Define CSR_STATS before including this file to collect per frame statistics (see csr_stats).
+ * Without it all counters and timers compile out completely.
+ */
+#ifdef CSR_STATS
+#include "perf.h"
+#endif
+
 /* #############################################################################
  * # MATRIX LAYOUT
  * #############################################################################
@@ -81,6 +88,61 @@ CSR_API CSR_INLINE int csr_maxi(int a, int b)
   return (a > b) ? a : b;
 }
 
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4699) /* MSVC-specific aliasing warning */
+#endif
+CSR_API CSR_INLINE float csr_invsqrt(float number)
+{
+  union
+  {
+    float f;
+    int i;
+  } conv;
+
+  float x2, y;
+
+  x2 = number * 0.5f;
+  conv.f = number;
+  conv.i = 0x5f3759df - (conv.i >> 1); /* Magic number for approximation */
+  y = conv.f;
+  y = y * (1.5f - (x2 * y * y)); /* One iteration of Newton's method */
+
+  return (y);
+}
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+CSR_API CSR_INLINE float csr_sqrtf(float x)
+{
+  return (x > 0.0f) ? (x * csr_invsqrt(x)) : 0.0f;
+}
+
+/* Normalizes a direction, a second Newton iteration keeps lighting of unit length vectors exact in 8 bits */
+CSR_API CSR_INLINE void csr_v3_normalize(float v[3])
+{
+  float length_squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+  float inv_length;
+
+  if (length_squared <= 0.0f)
+  {
+    return;
+  }
+
+  inv_length = csr_invsqrt(length_squared);
+  inv_length = inv_length * (1.5f - (length_squared * 0.5f * inv_length * inv_length));
+
+  v[0] *= inv_length;
+  v[1] *= inv_length;
+  v[2] *= inv_length;
+}
+
 CSR_API CSR_INLINE void csr_pos_init(float *pos, float x, float y, float z, float w)
 {
   pos[0] = x;
@@ -140,6 +202,27 @@ CSR_API CSR_INLINE void csr_m4x4_mul_v4(float result[4], float m[16], float v[4]
 #endif
 }
 
+/* Multiplies two 4x4 matrices (result = a * b), result must not alias a or b. */
+CSR_API CSR_INLINE void csr_m4x4_mul(float result[16], float a[16], float b[16])
+{
+  int col;
+
+  /* Every column of the result is a transformed column of b */
+  for (col = 0; col < 4; ++col)
+  {
+    float column[4];
+    float transformed[4];
+
+    csr_pos_init(column, b[CSR_M4X4_AT(0, col)], b[CSR_M4X4_AT(1, col)], b[CSR_M4X4_AT(2, col)], b[CSR_M4X4_AT(3, col)]);
+    csr_m4x4_mul_v4(transformed, a, column);
+
+    result[CSR_M4X4_AT(0, col)] = transformed[0];
+    result[CSR_M4X4_AT(1, col)] = transformed[1];
+    result[CSR_M4X4_AT(2, col)] = transformed[2];
+    result[CSR_M4X4_AT(3, col)] = transformed[3];
+  }
+}
+
 /* #############################################################################
  * # RENDERING Functions
  * #############################################################################
@@ -155,7 +238,10 @@ typedef struct csr_color
 typedef enum csr_render_mode
 {
   CSR_RENDER_SOLID = 0,
-  CSR_RENDER_WIREFRAME = 1
+  CSR_RENDER_WIREFRAME = 1, /* all three edges of every (not culled) triangle                     */
+  CSR_RENDER_LINES = 2,     /* indices are a line list (pairs), e.g. the unique edges of a mesh   */
+  CSR_RENDER_OVERDRAW = 3,  /* only counts depth tests and writes, see csr_overdraw_init          */
+  CSR_RENDER_LIT = 4        /* solid with a directional light, see csr_light_init                 */
 
 } csr_render_mode;
 
@@ -170,30 +256,265 @@ typedef enum csr_culling_mode
 
 } csr_culling_mode;
 
+typedef enum csr_framebuffer_format
+{
+  CSR_FRAMEBUFFER_RGB = 0, /* 3 byte csr_color per pixel, owned by the context memory   */
+  CSR_FRAMEBUFFER_XRGB = 1 /* packed 0x00RRGGBB unsigned int per pixel, external target */
+
+} csr_framebuffer_format;
+
+typedef enum csr_depth_format
+{
+  CSR_DEPTH_F32 = 0, /* 32 bit float NDC depth per pixel                              */
+  CSR_DEPTH_U16 = 1, /* 16 bit unorm depth per pixel, fixed point interpolation        */
+  CSR_DEPTH_U24 = 2  /* 24 bit packed unorm depth per pixel, fixed point interpolation */
+
+} csr_depth_format;
+
+/* Size of the square screen tiles used by the deferred clear */
+#define CSR_TILE_SIZE 32
+
+/* State of a screen tile for the deferred clear (csr_render_clear_screen_deferred). */
+typedef enum csr_tile_state
+{
+  CSR_TILE_DIRTY = 0,         /* color and depth hold rendered content                    */
+  CSR_TILE_CLEAR_PENDING = 1, /* color and depth still have to be cleared                 */
+  CSR_TILE_CLEAR_COLOR = 2    /* color holds the clear color, depth has to be cleared     */
+
+} csr_tile_state;
+
+#ifdef CSR_STATS
+/* Renderer statistics, accumulated while a csr_stats is attached to the context (context->stats).
+ * Screen triangles are counted after clipping, a clipped triangle can turn into several of them.
+ * Times are in cycles where a cycle counter is available, otherwise in nanoseconds. The timer is read
+ * once per draw call, timing the vertex and raster stages apart would need it per primitive.
+ */
+typedef struct csr_stats
+{
+  unsigned long triangles_submitted;        /* triangles passed to csr_render                        */
+  unsigned long triangles_culled_backface;  /* screen triangles culled by their winding order         */
+  unsigned long triangles_culled_offscreen; /* triangles completely outside of a frustum plane        */
+  unsigned long triangles_culled_near;      /* triangles completely behind the near plane or camera   */
+  unsigned long triangles_clipped;          /* triangles clipped at the near plane or the guard band  */
+  unsigned long triangles_rasterized;       /* screen triangles passed to the rasterizer              */
+  unsigned long lines_submitted;            /* lines passed to csr_render in CSR_RENDER_LINES mode    */
+  unsigned long lines_culled;               /* lines outside of a frustum plane or behind the camera  */
+  unsigned long lines_rasterized;           /* lines passed to the rasterizer                         */
+  unsigned long pixels_tested;              /* covered pixels that went through the depth test        */
+  unsigned long pixels_written;             /* pixels that passed the depth test                      */
+  unsigned long depth_rejects;              /* pixels that failed the depth test                      */
+  double render_time;                       /* draw calls: vertex processing and rasterization        */
+
+} csr_stats;
+
+CSR_API CSR_INLINE void csr_stats_reset(csr_stats *stats)
+{
+  stats->triangles_submitted = 0;
+  stats->triangles_culled_backface = 0;
+  stats->triangles_culled_offscreen = 0;
+  stats->triangles_culled_near = 0;
+  stats->triangles_clipped = 0;
+  stats->triangles_rasterized = 0;
+  stats->lines_submitted = 0;
+  stats->lines_culled = 0;
+  stats->lines_rasterized = 0;
+  stats->pixels_tested = 0;
+  stats->pixels_written = 0;
+  stats->depth_rejects = 0;
+  stats->render_time = 0.0;
+}
+
+CSR_API CSR_INLINE double csr_stats_time(void)
+{
+#if defined(__x86_64__) || defined(__i386__) || (defined(__aarch64__) && defined(__APPLE__))
+  return (double)perf_platform_current_cycle_count();
+#else
+  return perf_platform_current_time_nanoseconds();
+#endif
+}
+
+#define CSR_STATS_ONLY(code) code
+#define CSR_STATS_ADD(context, field, value)                         \
+  do                                                                 \
+  {                                                                  \
+    if ((context)->stats)                                            \
+    {                                                                \
+      (context)->stats->field += (unsigned long)(value);             \
+    }                                                                \
+  } while (0)
+#else
+#define CSR_STATS_ONLY(code)
+#define CSR_STATS_ADD(context, field, value) \
+  do                                         \
+  {                                          \
+  } while (0)
+#endif
+
 typedef struct csr_context
 {
 
-  int width;              /* render area width in pixels            */
-  int height;             /* render area height in pixels           */
-  csr_color *framebuffer; /* memory pointer for framebuffer         */
-  float *zbuffer;         /* memory pointer for zbuffer             */
+  int width;                                  /* render area width in pixels            */
+  int height;                                 /* render area height in pixels           */
+  csr_color *framebuffer;                     /* memory pointer for framebuffer (RGB)   */
+  unsigned int *framebuffer_xrgb;             /* memory pointer for framebuffer (XRGB)  */
+  int framebuffer_stride;                     /* framebuffer pixels per row             */
+  csr_framebuffer_format framebuffer_format;  /* which framebuffer pointer is used      */
+  csr_depth_format depth_format;              /* which zbuffer pointer is used          */
+  float *zbuffer;                             /* memory pointer for zbuffer (F32)       */
+  unsigned short *zbuffer_u16;                /* memory pointer for zbuffer (U16)       */
+  unsigned char *zbuffer_u24;                 /* memory pointer for zbuffer (U24)       */
+  unsigned char *tiles;                       /* csr_tile_state per screen tile         */
+  int tiles_x;                                /* number of tiles per row                */
+  int tiles_y;                                /* number of tile rows                    */
+  int tiles_deferred;                         /* 1 if any tile is not CSR_TILE_DIRTY    */
+  csr_color tiles_clear_color;                /* color of the last deferred clear       */
+  void *memory;                               /* memory passed on init                  */
+  unsigned long memory_size;                  /* size of memory passed on init          */
+  unsigned short *overdraw;                   /* depth tests and writes per pixel       */
+  unsigned short *overdraw_tiles;             /* triangles per screen tile              */
+  unsigned int *visibility_buffer;            /* optional primitive id per pixel        */
+  unsigned int draw_id;                       /* draw id written by the next draws      */
+  unsigned int primitive_id;                  /* packed id of the current primitive     */
+  unsigned long primitive_id_overflows;       /* draws with primitives without an id    */
+  float light_direction[3];                   /* normalized direction towards the light */
+  float light_ambient;                        /* light intensity of faces turned away   */
+  csr_color light_color;                      /* surface color of vertices without one  */
+  float *instance_vertices;                   /* optional clip space vertex cache       */
+  unsigned long instance_vertices_capacity;   /* vertices fitting into the cache        */
+#ifdef CSR_STATS
+  csr_stats *stats;                           /* optional statistics, 0 after init      */
+#endif
 
 } csr_context;
 
-CSR_API CSR_INLINE unsigned long csr_memory_size(int width, int height)
+CSR_API CSR_INLINE csr_color csr_init_color(unsigned char r, unsigned char g, unsigned char b)
+{
+  csr_color result;
+  result.r = r;
+  result.g = g;
+  result.b = b;
+
+  return result;
+}
+
+/* Sets the directional light used by CSR_RENDER_LIT.
+ * The direction points towards the light and is given in the model space of the draws.
+ * Ambient is the intensity of faces turned away from the light, color is used for vertices without a color.
+ */
+CSR_API CSR_INLINE void csr_light_init(csr_context *context, float x, float y, float z, float ambient, csr_color color)
+{
+  context->light_direction[0] = x;
+  context->light_direction[1] = y;
+  context->light_direction[2] = z;
+  csr_v3_normalize(context->light_direction);
+  context->light_ambient = csr_minf(csr_maxf(ambient, 0.0f), 1.0f);
+  context->light_color = color;
+}
+
+/* A primitive id packs the draw id (upper bits) and the triangle or line index within the draw (lower bits).
+ * Draw ids up to CSR_DRAW_ID_MAX (4094) and up to 2^20 primitives per draw get a unique id,
+ * the last draw id is taken by CSR_PRIMITIVE_ID_NONE.
+ */
+#define CSR_PRIMITIVE_ID_BITS 20
+#define CSR_PRIMITIVE_ID_MASK ((1U << CSR_PRIMITIVE_ID_BITS) - 1U)
+#define CSR_PRIMITIVE_ID_NONE 0xFFFFFFFFU
+#define CSR_DRAW_ID_MAX ((CSR_PRIMITIVE_ID_NONE >> CSR_PRIMITIVE_ID_BITS) - 1U)
+
+/* Primitives outside of the id range get CSR_PRIMITIVE_ID_NONE instead of the id of another primitive */
+CSR_API CSR_INLINE unsigned int csr_primitive_id(unsigned int draw_id, unsigned long primitive)
+{
+  if (draw_id > CSR_DRAW_ID_MAX || primitive > CSR_PRIMITIVE_ID_MASK)
+  {
+    return CSR_PRIMITIVE_ID_NONE;
+  }
+
+  return (draw_id << CSR_PRIMITIVE_ID_BITS) | (unsigned int)primitive;
+}
+
+/* Counts draws into the visibility buffer of which not every primitive can be picked, see csr_primitive_id */
+CSR_API CSR_INLINE void csr_primitive_id_check(csr_context *context, unsigned long primitives)
+{
+  if (context->visibility_buffer && (context->draw_id > CSR_DRAW_ID_MAX || primitives > CSR_PRIMITIVE_ID_MASK + 1UL))
+  {
+    context->primitive_id_overflows++;
+  }
+}
+
+CSR_API CSR_INLINE unsigned int csr_primitive_id_draw(unsigned int primitive_id)
+{
+  return primitive_id >> CSR_PRIMITIVE_ID_BITS;
+}
+
+CSR_API CSR_INLINE unsigned int csr_primitive_id_primitive(unsigned int primitive_id)
+{
+  return primitive_id & CSR_PRIMITIVE_ID_MASK;
+}
+
+CSR_API CSR_INLINE unsigned long csr_tiles_size(int width, int height)
+{
+  return (unsigned long)((width + CSR_TILE_SIZE - 1) / CSR_TILE_SIZE) *
+         (unsigned long)((height + CSR_TILE_SIZE - 1) / CSR_TILE_SIZE);
+}
+
+CSR_API CSR_INLINE void csr_tiles_init(csr_context *context, unsigned char *tiles)
+{
+  unsigned long i;
+  unsigned long count;
+
+  context->tiles = tiles;
+  context->tiles_x = (context->width + CSR_TILE_SIZE - 1) / CSR_TILE_SIZE;
+  context->tiles_y = (context->height + CSR_TILE_SIZE - 1) / CSR_TILE_SIZE;
+  context->tiles_deferred = 0;
+  context->tiles_clear_color.r = 0;
+  context->tiles_clear_color.g = 0;
+  context->tiles_clear_color.b = 0;
+
+  count = csr_tiles_size(context->width, context->height);
+
+  for (i = 0; i < count; ++i)
+  {
+    tiles[i] = CSR_TILE_DIRTY;
+  }
+}
+
+CSR_API CSR_INLINE unsigned long csr_depth_size(csr_depth_format depth_format)
+{
+  return depth_format == CSR_DEPTH_U16 ? 2 : depth_format == CSR_DEPTH_U24 ? 3 : (unsigned long)sizeof(float);
+}
+
+/* Binds the zbuffer of the requested format to memory and returns the size it occupies. */
+CSR_API CSR_INLINE unsigned long csr_depth_init(csr_context *context, void *memory, csr_depth_format depth_format)
+{
+  context->depth_format = depth_format;
+  context->zbuffer = depth_format == CSR_DEPTH_F32 ? (float *)memory : 0;
+  context->zbuffer_u16 = depth_format == CSR_DEPTH_U16 ? (unsigned short *)memory : 0;
+  context->zbuffer_u24 = depth_format == CSR_DEPTH_U24 ? (unsigned char *)memory : 0;
+
+  return (unsigned long)(context->width * context->height) * csr_depth_size(depth_format);
+}
+
+/* The RGB framebuffer is padded to 4 bytes so the zbuffer that follows it is aligned */
+CSR_API CSR_INLINE unsigned long csr_framebuffer_size(unsigned long area)
+{
+  return (area * (unsigned long)sizeof(csr_color) + 3) & ~3UL;
+}
+
+CSR_API CSR_INLINE unsigned long csr_memory_size(int width, int height, csr_depth_format depth_format)
 {
   unsigned long area = (unsigned long)(width * height);
 
-  return (unsigned long)(area * (unsigned long)sizeof(csr_color) + /* framebuffer size */
-                         area * (unsigned long)sizeof(float)       /* zbuffer size     */
+  return (unsigned long)(csr_framebuffer_size(area) +             /* framebuffer size */
+                         area * csr_depth_size(depth_format) +     /* zbuffer size     */
+                         csr_tiles_size(width, height)             /* tile states      */
   );
 }
 
-CSR_API CSR_INLINE int csr_init_model(csr_context *context, void *memory, unsigned long memory_size, int width, int height)
+CSR_API CSR_INLINE int csr_init_model(csr_context *context, void *memory, unsigned long memory_size, int width, int height, csr_depth_format depth_format)
 {
-  unsigned long memory_framebuffer_size = (unsigned long)(width * height) * (unsigned long)sizeof(csr_color);
+  unsigned long memory_framebuffer_size = csr_framebuffer_size((unsigned long)(width * height));
+  unsigned long memory_zbuffer_size;
 
-  if (memory_size < csr_memory_size(width, height))
+  if (memory_size < csr_memory_size(width, height, depth_format))
   {
     return 0;
   }
@@ -201,19 +522,90 @@ CSR_API CSR_INLINE int csr_init_model(csr_context *context, void *memory, unsign
   context->width = width;
   context->height = height;
   context->framebuffer = (csr_color *)memory;
-  context->zbuffer = (float *)((char *)memory + memory_framebuffer_size);
+  context->framebuffer_xrgb = 0;
+  context->framebuffer_stride = width;
+  context->framebuffer_format = CSR_FRAMEBUFFER_RGB;
+  context->memory = memory;
+  context->memory_size = memory_size;
+  context->overdraw = 0;
+  context->overdraw_tiles = 0;
+  context->visibility_buffer = 0;
+  context->draw_id = 0;
+  context->primitive_id = CSR_PRIMITIVE_ID_NONE;
+  context->primitive_id_overflows = 0;
+  context->instance_vertices = 0;
+  context->instance_vertices_capacity = 0;
+  csr_light_init(context, 0.3f, 0.6f, 0.75f, 0.2f, csr_init_color(200, 200, 200));
+  CSR_STATS_ONLY(context->stats = 0;)
+
+  memory_zbuffer_size = csr_depth_init(context, (char *)memory + memory_framebuffer_size, depth_format);
+  csr_tiles_init(context, (unsigned char *)memory + memory_framebuffer_size + memory_zbuffer_size);
 
   return 1;
 }
 
-CSR_API CSR_INLINE csr_color csr_init_color(unsigned char r, unsigned char g, unsigned char b)
+/* Memory size for rendering into an external XRGB target, only the zbuffer lives in the context memory. */
+CSR_API CSR_INLINE unsigned long csr_memory_size_xrgb(int width, int height, csr_depth_format depth_format)
 {
-  csr_color result;
-  result.r = r;
-  result.g = g;
-  result.b = b;
+  unsigned long area = (unsigned long)(width * height);
 
-  return result;
+  return (unsigned long)(area * csr_depth_size(depth_format) + /* zbuffer size */
+                         csr_tiles_size(width, height)         /* tile states  */
+  );
+}
+
+/* Renders directly into a packed 0x00RRGGBB target, e.g. a sub-rectangle of a window framebuffer.
+ * target points to the top left pixel (origin) of the render area and target_stride is the number
+ * of pixels per row of the surrounding buffer. Can be called again with the same memory to rebind
+ * the context to a different target as long as the memory is large enough.
+ */
+CSR_API CSR_INLINE int csr_init_model_xrgb(csr_context *context, void *memory, unsigned long memory_size, unsigned int *target, int target_stride, int width, int height, csr_depth_format depth_format)
+{
+  if (!target || target_stride < width || memory_size < csr_memory_size_xrgb(width, height, depth_format))
+  {
+    return 0;
+  }
+
+  context->width = width;
+  context->height = height;
+  context->framebuffer = 0;
+  context->framebuffer_xrgb = target;
+  context->framebuffer_stride = target_stride;
+  context->framebuffer_format = CSR_FRAMEBUFFER_XRGB;
+  context->memory = memory;
+  context->memory_size = memory_size;
+  context->overdraw = 0;
+  context->overdraw_tiles = 0;
+  context->visibility_buffer = 0;
+  context->draw_id = 0;
+  context->primitive_id = CSR_PRIMITIVE_ID_NONE;
+  context->primitive_id_overflows = 0;
+  context->instance_vertices = 0;
+  context->instance_vertices_capacity = 0;
+  csr_light_init(context, 0.3f, 0.6f, 0.75f, 0.2f, csr_init_color(200, 200, 200));
+  CSR_STATS_ONLY(context->stats = 0;)
+
+  csr_tiles_init(context, (unsigned char *)memory + csr_depth_init(context, memory, depth_format));
+
+  return 1;
+}
+
+CSR_API CSR_INLINE unsigned int csr_color_to_xrgb(csr_color color)
+{
+  return ((unsigned int)color.r << 16) | ((unsigned int)color.g << 8) | (unsigned int)color.b;
+}
+
+/* Writes a pixel at framebuffer_index (y * framebuffer_stride + x) in the format of the context. */
+CSR_API CSR_INLINE void csr_framebuffer_write(csr_context *context, int framebuffer_index, csr_color color)
+{
+  if (context->framebuffer_format == CSR_FRAMEBUFFER_XRGB)
+  {
+    context->framebuffer_xrgb[framebuffer_index] = csr_color_to_xrgb(color);
+  }
+  else
+  {
+    context->framebuffer[framebuffer_index] = color;
+  }
 }
 
 /* Converts a point from normalized device coordinates(NDC) to screen space. */
@@ -224,294 +616,2079 @@ CSR_API CSR_INLINE void csr_ndc_to_screen(csr_context *context, float result[3],
   result[2] = ndc_pos[2];
 }
 
-CSR_API CSR_INLINE void csr_render_clear_screen(csr_context *context, csr_color clear_color)
+/* Fills count depth values with wide stores. */
+CSR_API CSR_INLINE void csr_fill_depth(float *dst, int count, float value)
 {
-  int size = context->width * context->height;
+  int i = 0;
+
+#ifdef CSR_USE_SSE
+  __m128 v = _mm_set1_ps(value);
+
+  for (; i + 16 <= count; i += 16)
+  {
+    _mm_storeu_ps(dst + i, v);
+    _mm_storeu_ps(dst + i + 4, v);
+    _mm_storeu_ps(dst + i + 8, v);
+    _mm_storeu_ps(dst + i + 12, v);
+  }
+
+  for (; i + 4 <= count; i += 4)
+  {
+    _mm_storeu_ps(dst + i, v);
+  }
+#endif
+
+  for (; i < count; ++i)
+  {
+    dst[i] = value;
+  }
+}
 
+/* Fills count bytes with wide stores, used to clear the unorm depth formats. */
+CSR_API CSR_INLINE void csr_fill_bytes(unsigned char *dst, int count, unsigned char value)
+{
   int i = 0;
 
-  for (; i + 4 <= size; i += 4)
+#ifdef CSR_USE_SSE
+  union
+  {
+    unsigned char b[16];
+    float f[4];
+  } pattern;
+
+  __m128 v;
+
+  for (i = 0; i < 16; ++i)
+  {
+    pattern.b[i] = value;
+  }
+
+  /* Plain loads and stores move the bits unchanged, even if the pattern is a NaN */
+  v = _mm_loadu_ps(pattern.f);
+
+  for (i = 0; i + 64 <= count; i += 64)
   {
-    context->framebuffer[i] = clear_color;
-    context->framebuffer[i + 1] = clear_color;
-    context->framebuffer[i + 2] = clear_color;
-    context->framebuffer[i + 3] = clear_color;
-    context->zbuffer[i] = 1.0f;
-    context->zbuffer[i + 1] = 1.0f;
-    context->zbuffer[i + 2] = 1.0f;
-    context->zbuffer[i + 3] = 1.0f;
+    _mm_storeu_ps((float *)(void *)(dst + i), v);
+    _mm_storeu_ps((float *)(void *)(dst + i + 16), v);
+    _mm_storeu_ps((float *)(void *)(dst + i + 32), v);
+    _mm_storeu_ps((float *)(void *)(dst + i + 48), v);
   }
+#endif
 
-  for (; i < size; ++i)
+  for (; i < count; ++i)
   {
-    context->framebuffer[i] = clear_color;
-    context->zbuffer[i] = 1.0f;
+    dst[i] = value;
   }
 }
 
-/* Draws a line with depth testing using Bresenham's algorithm. */
-CSR_API CSR_INLINE void csr_draw_line(csr_context *context, float p0[3], float p1[3], csr_color color)
+/* Fills count packed XRGB pixels with wide stores. */
+CSR_API CSR_INLINE void csr_fill_xrgb(unsigned int *dst, int count, unsigned int value)
 {
-  int x0 = (int)p0[0], y0 = (int)p0[1];
-  int x1 = (int)p1[0], y1 = (int)p1[1];
-  float z0 = p0[2], z1 = p1[2];
+  int i = 0;
 
-  int dx = csr_absi(x1 - x0);
-  int sx = x0 < x1 ? 1 : -1;
-  int dy = -csr_absi(y1 - y0);
-  int sy = y0 < y1 ? 1 : -1;
+#ifdef CSR_USE_SSE
+  /* Plain loads and stores of the float lanes copy the bit pattern unchanged, even NaN patterns like 0xFFFFFFFF */
+  union
+  {
+    unsigned int u[4];
+    float f[4];
+  } pattern;
 
-  int err = dx + dy, e2;
-  float z = z0;
-  float dz = (float)(dx > -dy ? dx : -dy);
+  __m128 v;
 
-  dz = (dz == 0) ? 0.0f : (z1 - z0) / dz;
+  pattern.u[0] = pattern.u[1] = pattern.u[2] = pattern.u[3] = value;
+  v = _mm_loadu_ps(pattern.f);
 
-  while (1)
+  for (; i + 16 <= count; i += 16)
   {
-    if (x0 >= 0 && x0 < context->width && y0 >= 0 && y0 < context->height)
-    {
-      int index = y0 * context->width + x0;
+    _mm_storeu_ps((float *)(dst + i), v);
+    _mm_storeu_ps((float *)(dst + i + 4), v);
+    _mm_storeu_ps((float *)(dst + i + 8), v);
+    _mm_storeu_ps((float *)(dst + i + 12), v);
+  }
+#endif
 
-      if (z < context->zbuffer[index])
-      {
-        context->framebuffer[index] = color;
-        context->zbuffer[index] = z;
-      }
-    }
+  for (; i < count; ++i)
+  {
+    dst[i] = value;
+  }
+}
+
+/* Fills count 3 byte RGB pixels. With SSE 16 pixels (48 bytes) are written as three 16 byte stores. */
+CSR_API CSR_INLINE void csr_fill_rgb(csr_color *dst, int count, csr_color value)
+{
+  int i = 0;
 
-    if (x0 == x1 && y0 == y1)
+#ifdef CSR_USE_SSE
+  if (sizeof(csr_color) == 3 && count >= 16)
+  {
+    union
     {
-      break;
-    }
+      csr_color c[16];
+      float f[12];
+    } pattern;
 
-    e2 = 2 * err;
+    __m128 v0, v1, v2;
 
-    if (e2 >= dy)
+    for (i = 0; i < 16; ++i)
     {
-      err += dy;
-      x0 += sx;
-      z += dz;
+      pattern.c[i] = value;
     }
 
-    if (e2 <= dx)
+    v0 = _mm_loadu_ps(pattern.f);
+    v1 = _mm_loadu_ps(pattern.f + 4);
+    v2 = _mm_loadu_ps(pattern.f + 8);
+
+    for (i = 0; i + 16 <= count; i += 16)
     {
-      err += dx;
-      y0 += sy;
-      z += dz;
+      float *p = (float *)(void *)(dst + i);
+      _mm_storeu_ps(p, v0);
+      _mm_storeu_ps(p + 4, v1);
+      _mm_storeu_ps(p + 8, v2);
     }
   }
+#endif
+
+  for (; i < count; ++i)
+  {
+    dst[i] = value;
+  }
 }
 
-/* Fills a triangle using the barycentric coordinate method with color interpolation. */
-CSR_API CSR_INLINE void csr_draw_triangle(csr_context *context, float p0[3], float p1[3], float p2[3], csr_color c0, csr_color c1, csr_color c2)
+/* Clears the color plane of the pixel rectangle [x0, x1) x [y0, y1). */
+CSR_API CSR_INLINE void csr_clear_rect_color(csr_context *context, int x0, int y0, int x1, int y1, csr_color clear_color)
 {
-  /* Bounding box for the triangle */
-  int min_x = (int)csr_minf(p0[0], csr_minf(p1[0], p2[0]));
-  int min_y = (int)csr_minf(p0[1], csr_minf(p1[1], p2[1]));
-  int max_x = (int)csr_maxf(p0[0], csr_maxf(p1[0], p2[0]));
-  int max_y = (int)csr_maxf(p0[1], csr_maxf(p1[1], p2[1]));
-
-  /* Pre-calculate constants for barycentric coordinates */
-  float area = (p1[1] - p2[1]) * (p0[0] - p2[0]) + (p2[0] - p1[0]) * (p0[1] - p2[1]);
+  int stride = context->framebuffer_stride;
+  int w = x1 - x0;
+  int y;
 
-  if (area == 0.0f)
+  /* Full width rectangles of a tightly packed target are one contiguous run */
+  if (w == stride)
   {
-    return;
+    w *= y1 - y0;
+    y1 = y0 + 1;
   }
 
-  /* Clamp bounding box to screen dimensions */
-  min_x = csr_maxi(0, min_x);
-  min_y = csr_maxi(0, min_y);
-  max_x = csr_mini(context->width - 1, max_x);
-  max_y = csr_mini(context->height - 1, max_y);
+  if (context->framebuffer_format == CSR_FRAMEBUFFER_XRGB)
+  {
+    unsigned int clear_xrgb = csr_color_to_xrgb(clear_color);
 
+    for (y = y0; y < y1; ++y)
+    {
+      csr_fill_xrgb(context->framebuffer_xrgb + y * stride + x0, w, clear_xrgb);
+    }
+  }
+  else
   {
-    float inv_area = 1.0f / area;
+    for (y = y0; y < y1; ++y)
+    {
+      csr_fill_rgb(context->framebuffer + y * stride + x0, w, clear_color);
+    }
+  }
+}
 
-    /* Calculate barycentric coordinate derivatives with respect to x and y */
-    float w0_dx = (p1[1] - p2[1]) * inv_area;
-    float w1_dx = (p2[1] - p0[1]) * inv_area;
-    float w2_dx = -w0_dx - w1_dx;
+/* Clears the depth plane of the pixel rectangle [x0, x1) x [y0, y1). */
+CSR_API CSR_INLINE void csr_clear_rect_depth(csr_context *context, int x0, int y0, int x1, int y1)
+{
+  int w = x1 - x0;
+  int y;
 
-    float w0_dy = (p2[0] - p1[0]) * inv_area;
-    float w1_dy = (p0[0] - p2[0]) * inv_area;
-    float w2_dy = -w0_dy - w1_dy;
+  if (w == context->width)
+  {
+    w *= y1 - y0;
+    y1 = y0 + 1;
+  }
 
-    /* Initialize barycentric coordinates at the top-left of the bounding box */
-    float w0_start = ((p1[1] - p2[1]) * ((float)min_x - p2[0]) + (p2[0] - p1[0]) * ((float)min_y - p2[1])) * inv_area;
-    float w1_start = ((p2[1] - p0[1]) * ((float)min_x - p0[0]) + (p0[0] - p2[0]) * ((float)min_y - p0[1])) * inv_area;
-    float w2_start = 1.0f - w0_start - w1_start;
+  for (y = y0; y < y1; ++y)
+  {
+    int index = y * context->width + x0;
 
-    /* Pre-calculate color channel differences for interpolation */
-    float dr_dx = (c1.r - c0.r) * w1_dx + (c2.r - c0.r) * w2_dx;
-    float dg_dx = (c1.g - c0.g) * w1_dx + (c2.g - c0.g) * w2_dx;
-    float db_dx = (c1.b - c0.b) * w1_dx + (c2.b - c0.b) * w2_dx;
+    /* The far plane of the unorm formats is all bits set */
+    if (context->depth_format == CSR_DEPTH_U16)
+    {
+      csr_fill_bytes((unsigned char *)(context->zbuffer_u16 + index), w * 2, 0xFF);
+    }
+    else if (context->depth_format == CSR_DEPTH_U24)
+    {
+      csr_fill_bytes(context->zbuffer_u24 + index * 3, w * 3, 0xFF);
+    }
+    else
+    {
+      csr_fill_depth(context->zbuffer + index, w, 1.0f);
+    }
 
-    float dr_dy = (c1.r - c0.r) * w1_dy + (c2.r - c0.r) * w2_dy;
-    float dg_dy = (c1.g - c0.g) * w1_dy + (c2.g - c0.g) * w2_dy;
-    float db_dy = (c1.b - c0.b) * w1_dy + (c2.b - c0.b) * w2_dy;
+    /* The visibility buffer is cleared together with the depth it belongs to */
+    if (context->visibility_buffer)
+    {
+      csr_fill_xrgb(context->visibility_buffer + index, w, CSR_PRIMITIVE_ID_NONE);
+    }
+  }
+}
 
-    float r_start = c0.r + (c1.r - c0.r) * w1_start + (c2.r - c0.r) * w2_start;
-    float g_start = c0.g + (c1.g - c0.g) * w1_start + (c2.g - c0.g) * w2_start;
-    float b_start = c0.b + (c1.b - c0.b) * w1_start + (c2.b - c0.b) * w2_start;
+CSR_API CSR_INLINE void csr_render_clear_screen(csr_context *context, csr_color clear_color)
+{
+  int i;
+  int count = context->tiles_x * context->tiles_y;
 
-    int x, y;
+  csr_clear_rect_color(context, 0, 0, context->width, context->height, clear_color);
+  csr_clear_rect_depth(context, 0, 0, context->width, context->height);
 
-    for (y = min_y; y <= max_y; ++y)
+  /* Everything is cleared, pending deferred clears are obsolete */
+  if (context->tiles_deferred)
+  {
+    for (i = 0; i < count; ++i)
     {
-      float w0 = w0_start;
-      float w1 = w1_start;
-      float w2 = w2_start;
+      context->tiles[i] = CSR_TILE_DIRTY;
+    }
+
+    context->tiles_deferred = 0;
+  }
+}
+
+/* Only marks the screen tiles as cleared. A tile is materialized by the rasterizer the first time
+ * a triangle or line touches it, tiles that nothing touched are resolved by csr_render_resolve.
+ * Tiles that already hold the same clear color from a previous resolve skip the color write, so
+ * for mostly empty frames only the covered tiles cost any clear bandwidth.
+ */
+CSR_API CSR_INLINE void csr_render_clear_screen_deferred(csr_context *context, csr_color clear_color)
+{
+  int i;
+  int count = context->tiles_x * context->tiles_y;
+  int same_color = context->tiles_clear_color.r == clear_color.r &&
+                   context->tiles_clear_color.g == clear_color.g &&
+                   context->tiles_clear_color.b == clear_color.b;
+
+  for (i = 0; i < count; ++i)
+  {
+    if (context->tiles[i] != CSR_TILE_CLEAR_COLOR || !same_color)
+    {
+      context->tiles[i] = CSR_TILE_CLEAR_PENDING;
+    }
+  }
+
+  context->tiles_clear_color = clear_color;
+  context->tiles_deferred = 1;
+}
+
+/* Materializes the pending clears of all tiles overlapping the inclusive pixel bounds. */
+CSR_API CSR_INLINE void csr_tiles_touch(csr_context *context, int min_x, int min_y, int max_x, int max_y)
+{
+  int tx0 = min_x / CSR_TILE_SIZE;
+  int ty0 = min_y / CSR_TILE_SIZE;
+  int tx1 = max_x / CSR_TILE_SIZE;
+  int ty1 = max_y / CSR_TILE_SIZE;
+  int tx, ty;
+
+  for (ty = ty0; ty <= ty1; ++ty)
+  {
+    for (tx = tx0; tx <= tx1; ++tx)
+    {
+      unsigned char *tile = &context->tiles[ty * context->tiles_x + tx];
+
+      if (*tile != CSR_TILE_DIRTY)
+      {
+        int x0 = tx * CSR_TILE_SIZE;
+        int y0 = ty * CSR_TILE_SIZE;
+        int x1 = csr_mini(x0 + CSR_TILE_SIZE, context->width);
+        int y1 = csr_mini(y0 + CSR_TILE_SIZE, context->height);
+
+        if (*tile == CSR_TILE_CLEAR_PENDING)
+        {
+          csr_clear_rect_color(context, x0, y0, x1, y1, context->tiles_clear_color);
+        }
+
+        csr_clear_rect_depth(context, x0, y0, x1, y1);
+        *tile = CSR_TILE_DIRTY;
+      }
+    }
+  }
+}
+
+/* Writes the clear color into all tiles that were not touched since the last deferred clear.
+ * Call before presenting or reading the framebuffer. The depth of untouched tiles is never
+ * written, it is cleared lazily if more geometry touches the tile afterwards.
+ */
+CSR_API CSR_INLINE void csr_render_resolve(csr_context *context)
+{
+  int tx, ty;
+
+  if (!context->tiles_deferred)
+  {
+    return;
+  }
+
+  for (ty = 0; ty < context->tiles_y; ++ty)
+  {
+    for (tx = 0; tx < context->tiles_x; ++tx)
+    {
+      unsigned char *tile = &context->tiles[ty * context->tiles_x + tx];
+
+      if (*tile == CSR_TILE_CLEAR_PENDING)
+      {
+        int x0 = tx * CSR_TILE_SIZE;
+        int y0 = ty * CSR_TILE_SIZE;
+
+        csr_clear_rect_color(context, x0, y0, csr_mini(x0 + CSR_TILE_SIZE, context->width), csr_mini(y0 + CSR_TILE_SIZE, context->height), context->tiles_clear_color);
+        *tile = CSR_TILE_CLEAR_COLOR;
+      }
+    }
+  }
+}
+
+/* Number of bits of the unorm depth formats, 0 for CSR_DEPTH_F32. */
+CSR_API CSR_INLINE int csr_depth_bits(csr_depth_format depth_format)
+{
+  return depth_format == CSR_DEPTH_U16 ? 16 : depth_format == CSR_DEPTH_U24 ? 24 : 0;
+}
+
+/* Unorm depths are interpolated as fixed point with 31 - bits fractional bits so the
+ * accumulator stays in the signed 32 bit range. Returns the scale from a [0, 1] depth.
+ * The rasterizer starts the accumulator at the first covered pixel of a row, inside the
+ * triangle the depth stays in [0, scale] so there is no headroom needed for extrapolation.
+ */
+CSR_API CSR_INLINE float csr_depth_fixed_scale(csr_depth_format depth_format)
+{
+  int bits = csr_depth_bits(depth_format);
+
+  return (float)((1UL << bits) - 1UL) * (float)(1UL << (31 - bits));
+}
+
+/* Maps a NDC depth to a fixed point depth, out of range depths are clamped to the near and far plane. */
+CSR_API CSR_INLINE float csr_depth_fixed(float z, float depth_scale)
+{
+  return csr_minf(csr_maxf((z + 1.0f) * 0.5f, 0.0f), 1.0f) * depth_scale;
+}
+
+/* Converts a fixed point value to the wrapping accumulator of the rasterizer. */
+CSR_API CSR_INLINE unsigned int csr_depth_fixed_accumulator(float value)
+{
+  return (unsigned int)(int)csr_minf(csr_maxf(value, -2147483520.0f), 2147483520.0f);
+}
+
+/* Depth test of a unorm format with a fixed point depth. Stores the depth and returns 1 if the pixel is closer.
+ * Small negative rounding errors at the triangle edges wrap and are clamped to 0.
+ */
+CSR_API CSR_INLINE int csr_depth_test_fixed(csr_context *context, int index, unsigned int depth_fixed)
+{
+  int bits = csr_depth_bits(context->depth_format);
+  unsigned int depth = (depth_fixed & 0x80000000U) ? 0U : depth_fixed >> (31 - bits);
+
+  if (bits == 16)
+  {
+    if (depth < context->zbuffer_u16[index])
+    {
+      context->zbuffer_u16[index] = (unsigned short)depth;
+      return 1;
+    }
+  }
+  else
+  {
+    unsigned char *stored = context->zbuffer_u24 + index * 3;
+
+    if (depth < ((unsigned int)stored[0] | ((unsigned int)stored[1] << 8) | ((unsigned int)stored[2] << 16)))
+    {
+      stored[0] = (unsigned char)depth;
+      stored[1] = (unsigned char)(depth >> 8);
+      stored[2] = (unsigned char)(depth >> 16);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/* Depth test of a NDC depth in the format of the context. Stores the depth and returns 1 if the pixel is closer. */
+CSR_API CSR_INLINE int csr_depth_test(csr_context *context, int index, float z)
+{
+  if (context->depth_format == CSR_DEPTH_F32)
+  {
+    if (z < context->zbuffer[index])
+    {
+      context->zbuffer[index] = z;
+      return 1;
+    }
+
+    return 0;
+  }
+
+  return csr_depth_test_fixed(context, index, csr_depth_fixed_accumulator(csr_depth_fixed(z, csr_depth_fixed_scale(context->depth_format))));
+}
+
+/* Clips the segment p0 + t * (p1 - p0) to the rectangle [min_x, max_x] x [min_y, max_y] (Liang-Barsky).
+ * Returns 0 if nothing is visible, otherwise the visible part is t0 <= t <= t1.
+ */
+CSR_API CSR_INLINE int csr_clip_segment(float x0, float y0, float x1, float y1, float min_x, float min_y, float max_x, float max_y, float *t0, float *t1)
+{
+  float p[4];
+  float q[4];
+  int i;
+
+  p[0] = x0 - x1;
+  p[1] = x1 - x0;
+  p[2] = y0 - y1;
+  p[3] = y1 - y0;
+
+  q[0] = x0 - min_x;
+  q[1] = max_x - x0;
+  q[2] = y0 - min_y;
+  q[3] = max_y - y0;
+
+  *t0 = 0.0f;
+  *t1 = 1.0f;
+
+  for (i = 0; i < 4; ++i)
+  {
+    if (p[i] == 0.0f)
+    {
+      /* Parallel to this edge and outside of it */
+      if (q[i] < 0.0f)
+      {
+        return 0;
+      }
+    }
+    else
+    {
+      float t = q[i] / p[i];
+
+      if (p[i] < 0.0f)
+      {
+        *t0 = csr_maxf(*t0, t);
+      }
+      else
+      {
+        *t1 = csr_minf(*t1, t);
+      }
+    }
+  }
+
+  return *t0 <= *t1;
+}
+
+/* Draws a line with depth testing. The segment is clipped to the viewport first so that only visible
+ * pixels are stepped, the inner loop is a Bresenham (midpoint) walk along the major axis without bounds tests.
+ */
+CSR_API CSR_INLINE void csr_draw_line(csr_context *context, float p0[3], float p1[3], csr_color color)
+{
+  float t0, t1;
+  float dx_f = p1[0] - p0[0];
+  float dy_f = p1[1] - p0[1];
+  float dz_f = p1[2] - p0[2];
+
+  int x0, y0, x1, y1;
+  int dx, dy, major, minor, err, i;
+  int step_x, step_y, major_step, minor_step, major_step_fb, minor_step_fb;
+  int index, framebuffer_index;
+  float z, dz;
+  unsigned int *ids = context->visibility_buffer;
+  CSR_STATS_ONLY(unsigned long stats_written = 0;)
+
+  if (context->width < 1 || context->height < 1 ||
+      !csr_clip_segment(p0[0], p0[1], p1[0], p1[1], 0.0f, 0.0f, (float)(context->width - 1), (float)(context->height - 1), &t0, &t1))
+  {
+    return;
+  }
+
+  /* The clipped end points are clamped against rounding errors of far away coordinates,
+   * a walk between two points inside of the viewport never leaves it.
+   */
+  x0 = (int)csr_minf(csr_maxf(p0[0] + dx_f * t0, 0.0f), (float)(context->width - 1));
+  y0 = (int)csr_minf(csr_maxf(p0[1] + dy_f * t0, 0.0f), (float)(context->height - 1));
+  x1 = (int)csr_minf(csr_maxf(p0[0] + dx_f * t1, 0.0f), (float)(context->width - 1));
+  y1 = (int)csr_minf(csr_maxf(p0[1] + dy_f * t1, 0.0f), (float)(context->height - 1));
+
+  if (context->tiles_deferred)
+  {
+    csr_tiles_touch(context, csr_mini(x0, x1), csr_mini(y0, y1), csr_maxi(x0, x1), csr_maxi(y0, y1));
+  }
+
+  dx = csr_absi(x1 - x0);
+  dy = csr_absi(y1 - y0);
+  step_x = x0 < x1 ? 1 : -1;
+  step_y = y0 < y1 ? 1 : -1;
+
+  if (dx >= dy)
+  {
+    major = dx;
+    minor = dy;
+    major_step = step_x;
+    minor_step = step_y * context->width;
+    major_step_fb = step_x;
+    minor_step_fb = step_y * context->framebuffer_stride;
+  }
+  else
+  {
+    major = dy;
+    minor = dx;
+    major_step = step_y * context->width;
+    minor_step = step_x;
+    major_step_fb = step_y * context->framebuffer_stride;
+    minor_step_fb = step_x;
+  }
+
+  index = y0 * context->width + x0;
+  framebuffer_index = y0 * context->framebuffer_stride + x0;
+  z = p0[2] + dz_f * t0;
+  dz = major > 0 ? dz_f * (t1 - t0) / (float)major : 0.0f;
+  err = 2 * minor - major;
+
+  for (i = 0; i <= major; ++i)
+  {
+    /* All bits set if the minor axis steps as well */
+    int mask = -(err > 0);
+
+    if (csr_depth_test(context, index, z))
+    {
+      csr_framebuffer_write(context, framebuffer_index, color);
+      CSR_STATS_ONLY(++stats_written;)
+
+      if (ids)
+      {
+        ids[index] = context->primitive_id;
+      }
+    }
+
+    index += major_step + (minor_step & mask);
+    framebuffer_index += major_step_fb + (minor_step_fb & mask);
+    err += 2 * minor - ((2 * major) & mask);
+    z += dz;
+  }
+
+  CSR_STATS_ADD(context, pixels_tested, major + 1);
+  CSR_STATS_ADD(context, pixels_written, stats_written);
+  CSR_STATS_ADD(context, depth_rejects, (unsigned long)(major + 1) - stats_written);
+}
+
+/* Converts a color channel value or step to 16.16 fixed point. Inside of a triangle the values stay in
+ * [0, 255] and steps between covered pixels in [-255, 255], the clamp only guards the int range.
+ */
+CSR_API CSR_INLINE int csr_color_fixed(float value)
+{
+  return (int)(csr_minf(csr_maxf(value, -256.0f), 511.0f) * 65536.0f);
+}
+
+/* Truncates a 16.16 fixed point color channel, rounding errors at the triangle edges are clamped */
+CSR_API CSR_INLINE unsigned char csr_color_channel(int value)
+{
+  return (unsigned char)csr_mini(csr_maxi(value >> 16, 0), 255);
+}
+
+/* Fills a triangle using the barycentric coordinate method with color interpolation. */
+CSR_API CSR_INLINE void csr_draw_triangle(csr_context *context, float p0[3], float p1[3], float p2[3], csr_color c0, csr_color c1, csr_color c2)
+{
+  /* Bounding box for the triangle */
+  int min_x = (int)csr_minf(p0[0], csr_minf(p1[0], p2[0]));
+  int min_y = (int)csr_minf(p0[1], csr_minf(p1[1], p2[1]));
+  int max_x = (int)csr_maxf(p0[0], csr_maxf(p1[0], p2[0]));
+  int max_y = (int)csr_maxf(p0[1], csr_maxf(p1[1], p2[1]));
+
+  /* Pre-calculate constants for barycentric coordinates */
+  float area = (p1[1] - p2[1]) * (p0[0] - p2[0]) + (p2[0] - p1[0]) * (p0[1] - p2[1]);
+
+  if (area == 0.0f)
+  {
+    return;
+  }
+
+  /* Clamp bounding box to screen dimensions */
+  min_x = csr_maxi(0, min_x);
+  min_y = csr_maxi(0, min_y);
+  max_x = csr_mini(context->width - 1, max_x);
+  max_y = csr_mini(context->height - 1, max_y);
+
+  if (min_x > max_x || min_y > max_y)
+  {
+    return;
+  }
+
+  if (context->tiles_deferred)
+  {
+    csr_tiles_touch(context, min_x, min_y, max_x, max_y);
+  }
+
+  {
+    float inv_area = 1.0f / area;
+
+    /* Calculate barycentric coordinate derivatives with respect to x and y */
+    float w0_dx = (p1[1] - p2[1]) * inv_area;
+    float w1_dx = (p2[1] - p0[1]) * inv_area;
+    float w2_dx = -w0_dx - w1_dx;
+
+    float w0_dy = (p2[0] - p1[0]) * inv_area;
+    float w1_dy = (p0[0] - p2[0]) * inv_area;
+    float w2_dy = -w0_dy - w1_dy;
+
+    /* Initialize barycentric coordinates at the top-left of the bounding box */
+    float w0_start = ((p1[1] - p2[1]) * ((float)min_x - p2[0]) + (p2[0] - p1[0]) * ((float)min_y - p2[1])) * inv_area;
+    float w1_start = ((p2[1] - p0[1]) * ((float)min_x - p0[0]) + (p0[0] - p2[0]) * ((float)min_y - p0[1])) * inv_area;
+    float w2_start = 1.0f - w0_start - w1_start;
+
+    /* Pre-calculate color channel differences for interpolation */
+    float dr_dx = (c1.r - c0.r) * w1_dx + (c2.r - c0.r) * w2_dx;
+    float dg_dx = (c1.g - c0.g) * w1_dx + (c2.g - c0.g) * w2_dx;
+    float db_dx = (c1.b - c0.b) * w1_dx + (c2.b - c0.b) * w2_dx;
+
+    /* Colors are stepped along x in 16.16 fixed point, rows restart from the float values so errors do not accumulate */
+    int r_step = csr_color_fixed(dr_dx);
+    int g_step = csr_color_fixed(dg_dx);
+    int b_step = csr_color_fixed(db_dx);
+
+    /* Unorm depth formats interpolate a fixed point depth, steps along x are exact integer adds */
+    int depth_fixed = context->depth_format != CSR_DEPTH_F32;
+    float depth_scale = depth_fixed ? csr_depth_fixed_scale(context->depth_format) : 0.0f;
+    float d0 = csr_depth_fixed(p0[2], depth_scale);
+    float d1 = csr_depth_fixed(p1[2], depth_scale);
+    float d2 = csr_depth_fixed(p2[2], depth_scale);
+    unsigned int d_step = csr_depth_fixed_accumulator((d1 - d0) * w1_dx + (d2 - d0) * w2_dx);
+
+    unsigned int *ids = context->visibility_buffer;
+    unsigned int id = context->primitive_id;
+
+    int x, y;
+
+    CSR_STATS_ONLY(unsigned long stats_tested = 0;)
+    CSR_STATS_ONLY(unsigned long stats_written = 0;)
+
+    for (y = min_y; y <= max_y; ++y)
+    {
+      float w0 = w0_start;
+      float w1 = w1_start;
+      float w2 = w2_start;
+
+      int current_r = 0;
+      int current_g = 0;
+      int current_b = 0;
+
+      unsigned int current_d = 0;
+      int inside = 0;
+
+      int index_row_start = y * context->width + min_x;
+      int framebuffer_row_start = y * context->framebuffer_stride + min_x;
+
+      for (x = min_x; x <= max_x; ++x)
+      {
+        if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
+        {
+          int index = index_row_start + (x - min_x);
+          int passed;
+
+          /* The color and depth accumulators start at the first covered pixel of the row, extrapolating them
+           * from the bounding box corner loses the fixed point precision for thin and steep triangles
+           */
+          if (!inside)
+          {
+            current_r = csr_color_fixed(c0.r + (c1.r - c0.r) * w1 + (c2.r - c0.r) * w2);
+            current_g = csr_color_fixed(c0.g + (c1.g - c0.g) * w1 + (c2.g - c0.g) * w2);
+            current_b = csr_color_fixed(c0.b + (c1.b - c0.b) * w1 + (c2.b - c0.b) * w2);
+            current_d = csr_depth_fixed_accumulator(d0 + (d1 - d0) * w1 + (d2 - d0) * w2);
+            inside = 1;
+          }
+
+          CSR_STATS_ONLY(++stats_tested;)
+
+          if (depth_fixed)
+          {
+            passed = csr_depth_test_fixed(context, index, current_d);
+          }
+          else
+          {
+            /* Interpolate Z-depth using w values */
+            float z = p0[2] * w0 + p1[2] * w1 + p2[2] * w2;
+
+            /* Depth testing: only draw if the new pixel is closer than the existing one */
+            passed = z < context->zbuffer[index];
+
+            if (passed)
+            {
+              context->zbuffer[index] = z;
+            }
+          }
+
+          if (passed)
+          {
+            csr_color pixel_color;
+            pixel_color.r = csr_color_channel(current_r);
+            pixel_color.g = csr_color_channel(current_g);
+            pixel_color.b = csr_color_channel(current_b);
+
+            csr_framebuffer_write(context, framebuffer_row_start + (x - min_x), pixel_color);
+            CSR_STATS_ONLY(++stats_written;)
+
+            if (ids)
+            {
+              ids[index] = id;
+            }
+          }
+
+          current_r += r_step;
+          current_g += g_step;
+          current_b += b_step;
+          current_d += d_step;
+        }
+        else if (inside)
+        {
+          /* Rows of a triangle are convex, the rest of the row is outside */
+          break;
+        }
+
+        /* Increment barycentric coordinates with pre-calculated deltas */
+        w0 += w0_dx;
+        w1 += w1_dx;
+        w2 += w2_dx;
+      }
+
+      /* Reset w values for the start of the next row */
+      w0_start += w0_dy;
+      w1_start += w1_dy;
+      w2_start += w2_dy;
+    }
+
+    CSR_STATS_ADD(context, pixels_tested, stats_tested);
+    CSR_STATS_ADD(context, pixels_written, stats_written);
+    CSR_STATS_ADD(context, depth_rejects, stats_tested - stats_written);
+  }
+}
+
+/* Rasterizes a triangle into the overdraw counters instead of the framebuffer. Every covered pixel
+ * counts a depth test, pixels passing it count a write and update the zbuffer like a solid triangle.
+ * All screen tiles overlapping the bounding box count the triangle for the density view.
+ */
+CSR_API CSR_INLINE void csr_draw_triangle_overdraw(csr_context *context, float p0[3], float p1[3], float p2[3])
+{
+  int min_x = (int)csr_minf(p0[0], csr_minf(p1[0], p2[0]));
+  int min_y = (int)csr_minf(p0[1], csr_minf(p1[1], p2[1]));
+  int max_x = (int)csr_maxf(p0[0], csr_maxf(p1[0], p2[0]));
+  int max_y = (int)csr_maxf(p0[1], csr_maxf(p1[1], p2[1]));
+
+  float area = (p1[1] - p2[1]) * (p0[0] - p2[0]) + (p2[0] - p1[0]) * (p0[1] - p2[1]);
+
+  if (area == 0.0f || !context->overdraw)
+  {
+    return;
+  }
+
+  min_x = csr_maxi(0, min_x);
+  min_y = csr_maxi(0, min_y);
+  max_x = csr_mini(context->width - 1, max_x);
+  max_y = csr_mini(context->height - 1, max_y);
+
+  if (min_x > max_x || min_y > max_y)
+  {
+    return;
+  }
+
+  if (context->tiles_deferred)
+  {
+    csr_tiles_touch(context, min_x, min_y, max_x, max_y);
+  }
+
+  {
+    float inv_area = 1.0f / area;
+
+    float w0_dx = (p1[1] - p2[1]) * inv_area;
+    float w1_dx = (p2[1] - p0[1]) * inv_area;
+    float w2_dx = -w0_dx - w1_dx;
+
+    float w0_dy = (p2[0] - p1[0]) * inv_area;
+    float w1_dy = (p0[0] - p2[0]) * inv_area;
+    float w2_dy = -w0_dy - w1_dy;
+
+    float w0_start = ((p1[1] - p2[1]) * ((float)min_x - p2[0]) + (p2[0] - p1[0]) * ((float)min_y - p2[1])) * inv_area;
+    float w1_start = ((p2[1] - p0[1]) * ((float)min_x - p0[0]) + (p0[0] - p2[0]) * ((float)min_y - p0[1])) * inv_area;
+    float w2_start = 1.0f - w0_start - w1_start;
+
+    int x, y;
+
+    CSR_STATS_ONLY(unsigned long stats_tested = 0;)
+    CSR_STATS_ONLY(unsigned long stats_written = 0;)
+
+    for (y = min_y / CSR_TILE_SIZE; y <= max_y / CSR_TILE_SIZE; ++y)
+    {
+      for (x = min_x / CSR_TILE_SIZE; x <= max_x / CSR_TILE_SIZE; ++x)
+      {
+        ++context->overdraw_tiles[y * context->tiles_x + x];
+      }
+    }
+
+    for (y = min_y; y <= max_y; ++y)
+    {
+      float w0 = w0_start;
+      float w1 = w1_start;
+      float w2 = w2_start;
+
+      int index_row_start = y * context->width + min_x;
+
+      for (x = min_x; x <= max_x; ++x)
+      {
+        if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
+        {
+          int index = index_row_start + (x - min_x);
+          unsigned short *counters = &context->overdraw[index * 2];
+
+          ++counters[0];
+          CSR_STATS_ONLY(++stats_tested;)
+
+          if (csr_depth_test(context, index, p0[2] * w0 + p1[2] * w1 + p2[2] * w2))
+          {
+            ++counters[1];
+            CSR_STATS_ONLY(++stats_written;)
+          }
+        }
+
+        w0 += w0_dx;
+        w1 += w1_dx;
+        w2 += w2_dx;
+      }
+
+      w0_start += w0_dy;
+      w1_start += w1_dy;
+      w2_start += w2_dy;
+    }
+
+    CSR_STATS_ADD(context, pixels_tested, stats_tested);
+    CSR_STATS_ADD(context, pixels_written, stats_written);
+    CSR_STATS_ADD(context, depth_rejects, stats_tested - stats_written);
+  }
+}
+
+/* Culls a screen space triangle by its winding order and rasterizes it.
+ * edges selects the lines drawn in wireframe mode (bit 0: v0-v1, bit 1: v1-v2, bit 2: v2-v0).
+ */
+CSR_API CSR_INLINE void csr_render_screen_triangle(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, float v0_screen[3], float v1_screen[3], float v2_screen[3], csr_color color0, csr_color color1, csr_color color2, int edges)
+{
+  /* 4. Culling based on winding order */
+  if (culling_mode != CSR_CULLING_DISABLED)
+  {
+    float ax = v1_screen[0] - v0_screen[0];
+    float ay = v1_screen[1] - v0_screen[1];
+    float bx = v2_screen[0] - v0_screen[0];
+    float by = v2_screen[1] - v0_screen[1];
+    float face = ax * by - ay * bx;
+
+    int is_ccw_face = (face >= 0.0f);
+    int is_cw_face = (face <= 0.0f);
+
+    int should_cull = 0;
+
+    should_cull |= (culling_mode == CSR_CULLING_CCW_BACKFACE) & is_cw_face;
+    should_cull |= (culling_mode == CSR_CULLING_CCW_FRONTFACE) & is_ccw_face;
+    should_cull |= (culling_mode == CSR_CULLING_CW_BACKFACE) & is_ccw_face;
+    should_cull |= (culling_mode == CSR_CULLING_CW_FRONTFACE) & is_cw_face;
+
+    if (should_cull)
+    {
+      CSR_STATS_ADD(context, triangles_culled_backface, 1);
+      return;
+    }
+  }
+
+  CSR_STATS_ADD(context, triangles_rasterized, 1);
+
+  /* 5. Rasterization & Depth Testing */
+  if (render_mode == CSR_RENDER_SOLID || render_mode == CSR_RENDER_LIT)
+  {
+    csr_draw_triangle(context, v0_screen, v1_screen, v2_screen, color0, color1, color2);
+  }
+  else if (render_mode == CSR_RENDER_OVERDRAW)
+  {
+    csr_draw_triangle_overdraw(context, v0_screen, v1_screen, v2_screen);
+  }
+  else
+  {
+    if (edges & 1)
+    {
+      csr_draw_line(context, v0_screen, v1_screen, color0);
+    }
+
+    if (edges & 2)
+    {
+      csr_draw_line(context, v1_screen, v2_screen, color0);
+    }
+
+    if (edges & 4)
+    {
+      csr_draw_line(context, v2_screen, v0_screen, color0);
+    }
+  }
+}
+
+/* #############################################################################
+ * # CLIPPING Functions
+ * #############################################################################
+ *
+ * Triangles are classified in homogeneous clip space with outcodes.
+ * Triangles completely outside of one frustum plane are rejected before any setup.
+ * Triangles in front of the near plane and within the guard band are rasterized
+ * directly, the rasterizer clamps their bounding box to the viewport.
+ * Only triangles crossing the near plane or the guard band are clipped
+ * (Sutherland-Hodgman) so that geometry close to the camera does not pop out and
+ * gigantic screen space triangles do not lose precision in the setup.
+ */
+
+/* Guard band size as a multiple of the viewport, can be defined before including this file */
+#ifndef CSR_GUARD_BAND
+#define CSR_GUARD_BAND 8.0f
+#endif
+
+/* Outcode bits, the frustum planes are only used for trivial rejects, the near plane and the guard band are clipped against */
+typedef enum csr_clip_flag
+{
+  CSR_CLIP_LEFT = 1 << 0,
+  CSR_CLIP_RIGHT = 1 << 1,
+  CSR_CLIP_BOTTOM = 1 << 2,
+  CSR_CLIP_TOP = 1 << 3,
+  CSR_CLIP_FAR = 1 << 4,
+  CSR_CLIP_NEAR = 1 << 5,
+  CSR_CLIP_GUARD_LEFT = 1 << 6,
+  CSR_CLIP_GUARD_RIGHT = 1 << 7,
+  CSR_CLIP_GUARD_BOTTOM = 1 << 8,
+  CSR_CLIP_GUARD_TOP = 1 << 9,
+  CSR_CLIP_NEEDS_CLIPPING = CSR_CLIP_NEAR | CSR_CLIP_GUARD_LEFT | CSR_CLIP_GUARD_RIGHT | CSR_CLIP_GUARD_BOTTOM | CSR_CLIP_GUARD_TOP
+
+} csr_clip_flag;
+
+/* A triangle clipped against the 5 clipping planes has at most 3 + 5 vertices */
+#define CSR_CLIP_MAX_VERTICES 8
+
+typedef struct csr_clip_vertex
+{
+  float position[4]; /* clip space position                                              */
+  float color[3];    /* vertex color                                                     */
+  int edge;          /* 1 if the edge to the next vertex lies on an edge of the triangle */
+
+} csr_clip_vertex;
+
+CSR_API CSR_INLINE int csr_clip_code(float position[4])
+{
+  float x = position[0], y = position[1], z = position[2], w = position[3];
+  float g = CSR_GUARD_BAND * w;
+  int code = 0;
+
+  code |= (x < -w) ? CSR_CLIP_LEFT : 0;
+  code |= (x > w) ? CSR_CLIP_RIGHT : 0;
+  code |= (y < -w) ? CSR_CLIP_BOTTOM : 0;
+  code |= (y > w) ? CSR_CLIP_TOP : 0;
+  code |= (z > w) ? CSR_CLIP_FAR : 0;
+  code |= (z < -w) ? CSR_CLIP_NEAR : 0;
+  code |= (x < -g) ? CSR_CLIP_GUARD_LEFT : 0;
+  code |= (x > g) ? CSR_CLIP_GUARD_RIGHT : 0;
+  code |= (y < -g) ? CSR_CLIP_GUARD_BOTTOM : 0;
+  code |= (y > g) ? CSR_CLIP_GUARD_TOP : 0;
+
+  return code;
+}
+
+/* Signed distance to a clipping plane, positive is inside. */
+CSR_API CSR_INLINE float csr_clip_distance(float position[4], int plane)
+{
+  float g = CSR_GUARD_BAND * position[3];
+
+  switch (plane)
+  {
+  case CSR_CLIP_NEAR:
+    return position[2] + position[3];
+  case CSR_CLIP_GUARD_LEFT:
+    return g + position[0];
+  case CSR_CLIP_GUARD_RIGHT:
+    return g - position[0];
+  case CSR_CLIP_GUARD_BOTTOM:
+    return g + position[1];
+  default:
+    return g - position[1];
+  }
+}
+
+/* Clips a convex polygon against one plane and returns the number of output vertices. */
+CSR_API CSR_INLINE int csr_clip_polygon(csr_clip_vertex *out, csr_clip_vertex *in, int count, int plane)
+{
+  int out_count = 0;
+  int i, j;
+
+  for (i = 0; i < count; ++i)
+  {
+    csr_clip_vertex *current = &in[i];
+    csr_clip_vertex *next = &in[(i + 1) % count];
+    float d0 = csr_clip_distance(current->position, plane);
+    float d1 = csr_clip_distance(next->position, plane);
+
+    if (d0 >= 0.0f)
+    {
+      out[out_count++] = *current;
+    }
+
+    /* The edge crosses the plane, emit the intersection */
+    if ((d0 >= 0.0f) != (d1 >= 0.0f))
+    {
+      csr_clip_vertex *intersection = &out[out_count++];
+      float t = d0 / (d0 - d1);
+
+      for (j = 0; j < 4; ++j)
+      {
+        intersection->position[j] = current->position[j] + (next->position[j] - current->position[j]) * t;
+      }
+
+      for (j = 0; j < 3; ++j)
+      {
+        intersection->color[j] = current->color[j] + (next->color[j] - current->color[j]) * t;
+      }
+
+      /* Leaving the plane the new edge runs along the plane, entering it continues the source edge */
+      intersection->edge = d0 >= 0.0f ? 0 : current->edge;
+    }
+  }
+
+  return out_count;
+}
+
+CSR_API CSR_INLINE void csr_clip_vertex_init(csr_clip_vertex *vertex, float position[4], csr_color color)
+{
+  csr_pos_init(vertex->position, position[0], position[1], position[2], position[3]);
+  vertex->color[0] = (float)color.r;
+  vertex->color[1] = (float)color.g;
+  vertex->color[2] = (float)color.b;
+  vertex->edge = 1;
+}
+
+CSR_API CSR_INLINE void csr_clip_vertex_to_screen(csr_context *context, float result[3], csr_color *color, csr_clip_vertex *vertex)
+{
+  float ndc[4];
+
+  csr_v4_divf(ndc, vertex->position, vertex->position[3]);
+  csr_ndc_to_screen(context, result, ndc);
+
+  color->r = (unsigned char)(vertex->color[0] + 0.5f);
+  color->g = (unsigned char)(vertex->color[1] + 0.5f);
+  color->b = (unsigned char)(vertex->color[2] + 0.5f);
+}
+
+/* Clips a clip space triangle against the planes in clip_code and renders the resulting polygon as a triangle fan. */
+CSR_API CSR_INLINE void csr_render_clipped_triangle(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, float v0[4], float v1[4], float v2[4], csr_color color0, csr_color color1, csr_color color2, int clip_code)
+{
+  csr_clip_vertex polygon[2][CSR_CLIP_MAX_VERTICES];
+  int count = 3;
+  int current = 0;
+  int plane;
+  int i;
+
+  float first_screen[3];
+  float previous_screen[3];
+  csr_color first_color;
+  csr_color previous_color;
+
+  csr_clip_vertex_init(&polygon[0][0], v0, color0);
+  csr_clip_vertex_init(&polygon[0][1], v1, color1);
+  csr_clip_vertex_init(&polygon[0][2], v2, color2);
+
+  for (plane = CSR_CLIP_NEAR; plane <= CSR_CLIP_GUARD_TOP && count >= 3; plane <<= 1)
+  {
+    if (clip_code & plane)
+    {
+      count = csr_clip_polygon(polygon[current ^ 1], polygon[current], count, plane);
+      current ^= 1;
+    }
+  }
+
+  if (count < 3)
+  {
+    CSR_STATS_ADD(context, triangles_culled_offscreen, 1);
+    return;
+  }
+
+  /* In front of the near plane w is positive unless the matrix is degenerate */
+  for (i = 0; i < count; ++i)
+  {
+    if (polygon[current][i].position[3] <= 0.0f)
+    {
+      CSR_STATS_ADD(context, triangles_culled_near, 1);
+      return;
+    }
+  }
+
+  csr_clip_vertex_to_screen(context, first_screen, &first_color, &polygon[current][0]);
+  csr_clip_vertex_to_screen(context, previous_screen, &previous_color, &polygon[current][1]);
+
+  for (i = 2; i < count; ++i)
+  {
+    float next_screen[3];
+    csr_color next_color;
+
+    /* Only the outer edges of the fan are drawn in wireframe mode */
+    int edges = (i == 2 ? polygon[current][0].edge : 0) |
+                (polygon[current][i - 1].edge << 1) |
+                (i == count - 1 ? polygon[current][i].edge << 2 : 0);
+
+    csr_clip_vertex_to_screen(context, next_screen, &next_color, &polygon[current][i]);
+    csr_render_screen_triangle(context, render_mode, culling_mode, first_screen, previous_screen, next_screen, first_color, previous_color, next_color, edges);
+
+    previous_screen[0] = next_screen[0];
+    previous_screen[1] = next_screen[1];
+    previous_screen[2] = next_screen[2];
+    previous_color = next_color;
+  }
+}
+
+/* Renders a line list, indices holds two vertex indices per line so that shared edges of a mesh are drawn once.
+ * Lines are clipped against the near plane here, the rasterizer clips them to the viewport.
+ */
+CSR_API CSR_INLINE void csr_render_lines(csr_context *context, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_model_matrix[16])
+{
+  unsigned long i;
+
+  CSR_STATS_ONLY(double stats_start = context->stats ? csr_stats_time() : 0.0;)
+
+  (void)num_vertices;
+
+  CSR_STATS_ADD(context, lines_submitted, num_indices / 2);
+  csr_primitive_id_check(context, num_indices / 2);
+
+  for (i = 0; i + 1 < num_indices; i += 2)
+  {
+    int i0 = indices[i];
+    int i1 = indices[i + 1];
+
+    float pos0[4];
+    float pos1[4];
+
+    float v0_transformed[4];
+    float v1_transformed[4];
+
+    float v0_ndc[4];
+    float v1_ndc[4];
+
+    float v0_screen[3];
+    float v1_screen[3];
+
+    int code0, code1;
+
+    csr_color color = stride == 3 ? csr_init_color(255, 50, 50) : csr_init_color((unsigned char)vertices[i0 * stride + 3], (unsigned char)vertices[i0 * stride + 4], (unsigned char)vertices[i0 * stride + 5]);
+
+    csr_pos_init(pos0, vertices[i0 * stride + 0], vertices[i0 * stride + 1], vertices[i0 * stride + 2], 1.0f);
+    csr_pos_init(pos1, vertices[i1 * stride + 0], vertices[i1 * stride + 1], vertices[i1 * stride + 2], 1.0f);
+
+    csr_m4x4_mul_v4(v0_transformed, projection_view_model_matrix, pos0);
+    csr_m4x4_mul_v4(v1_transformed, projection_view_model_matrix, pos1);
+
+    code0 = csr_clip_code(v0_transformed);
+    code1 = csr_clip_code(v1_transformed);
+
+    /* Both end points are outside of the same plane */
+    if (code0 & code1)
+    {
+      CSR_STATS_ADD(context, lines_culled, 1);
+      continue;
+    }
+
+    /* Move the end point behind the near plane onto it */
+    if ((code0 | code1) & CSR_CLIP_NEAR)
+    {
+      float d0 = csr_clip_distance(v0_transformed, CSR_CLIP_NEAR);
+      float d1 = csr_clip_distance(v1_transformed, CSR_CLIP_NEAR);
+      float t = d0 / (d0 - d1);
+      float *outside = (code0 & CSR_CLIP_NEAR) ? v0_transformed : v1_transformed;
+      int j;
+
+      for (j = 0; j < 4; ++j)
+      {
+        outside[j] = v0_transformed[j] + (v1_transformed[j] - v0_transformed[j]) * t;
+      }
+    }
+
+    if (v0_transformed[3] <= 0.0f || v1_transformed[3] <= 0.0f)
+    {
+      CSR_STATS_ADD(context, lines_culled, 1);
+      continue;
+    }
+
+    csr_v4_divf(v0_ndc, v0_transformed, v0_transformed[3]);
+    csr_v4_divf(v1_ndc, v1_transformed, v1_transformed[3]);
+
+    csr_ndc_to_screen(context, v0_screen, v0_ndc);
+    csr_ndc_to_screen(context, v1_screen, v1_ndc);
+
+    CSR_STATS_ADD(context, lines_rasterized, 1);
+    context->primitive_id = csr_primitive_id(context->draw_id, i / 2);
+
+    csr_draw_line(context, v0_screen, v1_screen, color);
+  }
+
+#ifdef CSR_STATS
+  if (context->stats)
+  {
+    context->stats->render_time += csr_stats_time() - stats_start;
+  }
+#endif
+}
+
+/* Normalized face normal pointing to the side CSR_CULLING_CCW_BACKFACE keeps (clockwise in a right handed model space) */
+CSR_API CSR_INLINE void csr_face_normal(float result[3], float p0[3], float p1[3], float p2[3])
+{
+  float e0x = p1[0] - p0[0];
+  float e0y = p1[1] - p0[1];
+  float e0z = p1[2] - p0[2];
+  float e1x = p2[0] - p0[0];
+  float e1y = p2[1] - p0[1];
+  float e1z = p2[2] - p0[2];
+
+  result[0] = e1y * e0z - e1z * e0y;
+  result[1] = e1z * e0x - e1x * e0z;
+  result[2] = e1x * e0y - e1y * e0x;
+
+  csr_v3_normalize(result);
+}
+
+/* Lambert intensity of a normal in 8.8 fixed point (256 = fully lit), faces turned away get the ambient term */
+CSR_API CSR_INLINE unsigned int csr_light_intensity(csr_context *context, float normal[3])
+{
+  float n_dot_l = normal[0] * context->light_direction[0] + normal[1] * context->light_direction[1] + normal[2] * context->light_direction[2];
+  float intensity = context->light_ambient + (1.0f - context->light_ambient) * csr_maxf(n_dot_l, 0.0f);
+
+  return (unsigned int)(csr_minf(intensity, 1.0f) * 256.0f + 0.5f);
+}
+
+CSR_API CSR_INLINE csr_color csr_light_apply(csr_color color, unsigned int intensity)
+{
+  return csr_init_color(
+      (unsigned char)((color.r * intensity) >> 8),
+      (unsigned char)((color.g * intensity) >> 8),
+      (unsigned char)((color.b * intensity) >> 8));
+}
+
+/* Everything after the vertex transform of one triangle: lighting, clipping, perspective divide and rasterization.
+ * Colors and model space positions for lighting are read from the vertex array.
+ */
+CSR_API CSR_INLINE void csr_render_transformed_triangle(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, int i0, int i1, int i2, float v0_transformed[4], float v1_transformed[4], float v2_transformed[4], int clipping)
+{
+  float v0_ndc[4];
+  float v1_ndc[4];
+  float v2_ndc[4];
+
+  float v0_screen[3];
+  float v1_screen[3];
+  float v2_screen[3];
+
+  csr_color color0 = stride == 3 ? csr_init_color(255, 50, 50) : csr_init_color((unsigned char)vertices[i0 * stride + 3], (unsigned char)vertices[i0 * stride + 4], (unsigned char)vertices[i0 * stride + 5]);
+  csr_color color1 = stride == 3 ? csr_init_color(50, 255, 50) : csr_init_color((unsigned char)vertices[i1 * stride + 3], (unsigned char)vertices[i1 * stride + 4], (unsigned char)vertices[i1 * stride + 5]);
+  csr_color color2 = stride == 3 ? csr_init_color(50, 50, 255) : csr_init_color((unsigned char)vertices[i2 * stride + 3], (unsigned char)vertices[i2 * stride + 4], (unsigned char)vertices[i2 * stride + 5]);
+
+  /* Lighting happens once per triangle before clipping so clipped vertices interpolate the lit colors */
+  if (render_mode == CSR_RENDER_LIT)
+  {
+    if (stride < 6)
+    {
+      color0 = context->light_color;
+      color1 = context->light_color;
+      color2 = context->light_color;
+    }
+
+    if (stride >= 9)
+    {
+      color0 = csr_light_apply(color0, csr_light_intensity(context, &vertices[i0 * stride + 6]));
+      color1 = csr_light_apply(color1, csr_light_intensity(context, &vertices[i1 * stride + 6]));
+      color2 = csr_light_apply(color2, csr_light_intensity(context, &vertices[i2 * stride + 6]));
+    }
+    else
+    {
+      float normal[3];
+      unsigned int intensity;
+
+      csr_face_normal(normal, &vertices[i0 * stride], &vertices[i1 * stride], &vertices[i2 * stride]);
+      intensity = csr_light_intensity(context, normal);
+
+      color0 = csr_light_apply(color0, intensity);
+      color1 = csr_light_apply(color1, intensity);
+      color2 = csr_light_apply(color2, intensity);
+    }
+  }
+
+  if (clipping)
+  {
+    int code0 = csr_clip_code(v0_transformed);
+    int code1 = csr_clip_code(v1_transformed);
+    int code2 = csr_clip_code(v2_transformed);
+    int clip_code = (code0 | code1 | code2) & CSR_CLIP_NEEDS_CLIPPING;
+
+    /* All vertices are outside of the same plane */
+    if (code0 & code1 & code2)
+    {
+      CSR_STATS_ADD(context, triangles_culled_near, (code0 & code1 & code2 & CSR_CLIP_NEAR) != 0);
+      CSR_STATS_ADD(context, triangles_culled_offscreen, (code0 & code1 & code2 & CSR_CLIP_NEAR) == 0);
+      return;
+    }
+
+    if (clip_code)
+    {
+      CSR_STATS_ADD(context, triangles_clipped, 1);
+      csr_render_clipped_triangle(context, render_mode, culling_mode, v0_transformed, v1_transformed, v2_transformed, color0, color1, color2, clip_code);
+      return;
+    }
+  }
+
+  /* Degenerate matrices can still produce vertices behind the camera */
+  if (v0_transformed[3] <= 0.0f || v1_transformed[3] <= 0.0f || v2_transformed[3] <= 0.0f)
+  {
+    CSR_STATS_ADD(context, triangles_culled_near, 1);
+    return;
+  }
+
+  /* 2. Perspective Divide (Clip Space to NDC) */
+  csr_v4_divf(v0_ndc, v0_transformed, v0_transformed[3]);
+  csr_v4_divf(v1_ndc, v1_transformed, v1_transformed[3]);
+  csr_v4_divf(v2_ndc, v2_transformed, v2_transformed[3]);
+
+  /* 3. Viewport Transform (NDC to Screen Space) */
+  csr_ndc_to_screen(context, v0_screen, v0_ndc);
+  csr_ndc_to_screen(context, v1_screen, v1_ndc);
+  csr_ndc_to_screen(context, v2_screen, v2_ndc);
+
+  csr_render_screen_triangle(context, render_mode, culling_mode, v0_screen, v1_screen, v2_screen, color0, color1, color2, 7);
+}
+
+/* Renders indexed triangles. Without clipping the caller guarantees that all vertices are inside of the
+ * frustum (e.g. a bounding sphere classified as CSR_VISIBILITY_INSIDE) and the outcodes are skipped.
+ * CSR_RENDER_LIT uses per vertex normals at offset 6 when the stride is at least 9, otherwise face normals.
+ */
+CSR_API CSR_INLINE void csr_render_triangles(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_model_matrix[16], int clipping)
+{
+  unsigned long i;
+
+  CSR_STATS_ONLY(double stats_start;)
+
+  if (render_mode == CSR_RENDER_LINES)
+  {
+    csr_render_lines(context, stride, vertices, num_vertices, indices, num_indices, projection_view_model_matrix);
+    return;
+  }
+
+  CSR_STATS_ONLY(stats_start = context->stats ? csr_stats_time() : 0.0;)
+  CSR_STATS_ADD(context, triangles_submitted, num_indices / 3);
+  csr_primitive_id_check(context, num_indices / 3);
+
+  for (i = 0; i < num_indices; i += 3)
+  {
+    /* Get vertex indices for the current triangle */
+    int i0 = indices[i];
+    int i1 = indices[i + 1];
+    int i2 = indices[i + 2];
+
+    /* Get the vertex data from the main vertex array using the indices, and convert to homogeneous coordinates */
+    float pos0[4];
+    float pos1[4];
+    float pos2[4];
+
+    /* 1. Vertex Processing (Model, View, Projection) */
+    float v0_transformed[4];
+    float v1_transformed[4];
+    float v2_transformed[4];
+
+    csr_pos_init(pos0, vertices[i0 * stride + 0], vertices[i0 * stride + 1], vertices[i0 * stride + 2], 1.0f);
+    csr_pos_init(pos1, vertices[i1 * stride + 0], vertices[i1 * stride + 1], vertices[i1 * stride + 2], 1.0f);
+    csr_pos_init(pos2, vertices[i2 * stride + 0], vertices[i2 * stride + 1], vertices[i2 * stride + 2], 1.0f);
+
+    csr_m4x4_mul_v4(v0_transformed, projection_view_model_matrix, pos0);
+    csr_m4x4_mul_v4(v1_transformed, projection_view_model_matrix, pos1);
+    csr_m4x4_mul_v4(v2_transformed, projection_view_model_matrix, pos2);
+
+    context->primitive_id = csr_primitive_id(context->draw_id, i / 3);
+
+    csr_render_transformed_triangle(context, render_mode, culling_mode, stride, vertices, i0, i1, i2, v0_transformed, v1_transformed, v2_transformed, clipping);
+  }
+
+#ifdef CSR_STATS
+  if (context->stats)
+  {
+    context->stats->render_time += csr_stats_time() - stats_start;
+  }
+#endif
+}
+
+CSR_API CSR_INLINE void csr_render(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_model_matrix[16])
+{
+  csr_render_triangles(context, render_mode, culling_mode, stride, vertices, num_vertices, indices, num_indices, projection_view_model_matrix, 1);
+}
+
+/* #############################################################################
+ * # OVERDRAW Functions
+ * #############################################################################
+ *
+ * Debug views for finding expensive geometry. Triangles rendered with CSR_RENDER_OVERDRAW
+ * only count per pixel depth tests and writes and per screen tile the number of triangles.
+ * csr_overdraw_resolve turns one of the counters into a heatmap in the framebuffer.
+ */
+typedef enum csr_overdraw_view
+{
+  CSR_OVERDRAW_TESTS = 0,    /* depth tests per pixel (depth complexity)        */
+  CSR_OVERDRAW_WRITES = 1,   /* depth test passes per pixel (shaded fragments)  */
+  CSR_OVERDRAW_TRIANGLES = 2 /* triangles per screen tile (triangle density)    */
+
+} csr_overdraw_view;
+
+CSR_API CSR_INLINE unsigned long csr_overdraw_memory_size(int width, int height)
+{
+  return (unsigned long)(width * height) * 2 * (unsigned long)sizeof(unsigned short) + /* tests and writes per pixel */
+         csr_tiles_size(width, height) * (unsigned long)sizeof(unsigned short);          /* triangles per tile         */
+}
+
+CSR_API CSR_INLINE void csr_overdraw_clear(csr_context *context)
+{
+  int i;
+  int count = context->width * context->height * 2;
+
+  for (i = 0; i < count; ++i)
+  {
+    context->overdraw[i] = 0;
+  }
+
+  count = context->tiles_x * context->tiles_y;
+
+  for (i = 0; i < count; ++i)
+  {
+    context->overdraw_tiles[i] = 0;
+  }
+}
+
+/* Attaches the counter planes to an initialized context, the counters start cleared.
+ * Has to be called again after the context has been (re)initialized.
+ */
+CSR_API CSR_INLINE int csr_overdraw_init(csr_context *context, void *memory, unsigned long memory_size)
+{
+  if (!memory || memory_size < csr_overdraw_memory_size(context->width, context->height))
+  {
+    return 0;
+  }
+
+  context->overdraw = (unsigned short *)memory;
+  context->overdraw_tiles = context->overdraw + context->width * context->height * 2;
+
+  csr_overdraw_clear(context);
+
+  return 1;
+}
+
+/* Maps count / max_count onto a black, blue, green, yellow, red ramp. Counts above max_count are white. */
+CSR_API CSR_INLINE csr_color csr_overdraw_heatmap(unsigned int count, unsigned int max_count)
+{
+  static const unsigned char ramp[5][3] = {
+      {0, 0, 0},
+      {0, 0, 255},
+      {0, 255, 0},
+      {255, 255, 0},
+      {255, 0, 0}};
+
+  unsigned int t;
+  unsigned int stop;
+  unsigned int f;
+
+  if (count == 0)
+  {
+    return csr_init_color(0, 0, 0);
+  }
+
+  if (count > max_count)
+  {
+    return csr_init_color(255, 255, 255);
+  }
+
+  /* Position on the ramp in 1/256 steps between two stops */
+  t = (count * 4 * 256) / max_count;
+  stop = t >> 8;
+  f = t & 255;
+
+  if (stop >= 4)
+  {
+    return csr_init_color(ramp[4][0], ramp[4][1], ramp[4][2]);
+  }
+
+  return csr_init_color(
+      (unsigned char)((ramp[stop][0] * (256 - f) + ramp[stop + 1][0] * f) >> 8),
+      (unsigned char)((ramp[stop][1] * (256 - f) + ramp[stop + 1][1] * f) >> 8),
+      (unsigned char)((ramp[stop][2] * (256 - f) + ramp[stop + 1][2] * f) >> 8));
+}
+
+/* Writes the heatmap of a counter into the framebuffer, max_count is the count shown as red. */
+CSR_API CSR_INLINE void csr_overdraw_resolve(csr_context *context, csr_overdraw_view view, unsigned int max_count)
+{
+  int x, y;
+
+  if (!context->overdraw)
+  {
+    return;
+  }
+
+  /* Every pixel is written, pending clears must not overwrite the heatmap later on */
+  if (context->tiles_deferred)
+  {
+    csr_tiles_touch(context, 0, 0, context->width - 1, context->height - 1);
+    context->tiles_deferred = 0;
+  }
 
-      float current_r = r_start;
-      float current_g = g_start;
-      float current_b = b_start;
+  for (y = 0; y < context->height; ++y)
+  {
+    for (x = 0; x < context->width; ++x)
+    {
+      int index = y * context->width + x;
+      unsigned int count = view == CSR_OVERDRAW_TRIANGLES
+                               ? context->overdraw_tiles[(y / CSR_TILE_SIZE) * context->tiles_x + x / CSR_TILE_SIZE]
+                               : context->overdraw[index * 2 + (view == CSR_OVERDRAW_WRITES)];
 
-      int index_row_start = y * context->width + min_x;
+      csr_framebuffer_write(context, y * context->framebuffer_stride + x, csr_overdraw_heatmap(count, max_count));
+    }
+  }
+}
 
-      for (x = min_x; x <= max_x; ++x)
-      {
-        if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
-        {
-          /* Interpolate Z-depth using w values */
-          float z = p0[2] * w0 + p1[2] * w1 + p2[2] * w2;
+/* #############################################################################
+ * # VISIBILITY BUFFER Functions
+ * #############################################################################
+ *
+ * Optionally stores the primitive id (csr_primitive_id) of the visible triangle or line
+ * per pixel next to the depth. Picking is a single read of the buffer after rendering,
+ * the draw id is taken from context->draw_id when a draw is rendered.
+ * Draws beyond the id range leave CSR_PRIMITIVE_ID_NONE and are counted in context->primitive_id_overflows.
+ */
+CSR_API CSR_INLINE unsigned long csr_visibility_buffer_size(int width, int height)
+{
+  return (unsigned long)(width * height) * (unsigned long)sizeof(unsigned int);
+}
 
-          int index = index_row_start + (x - min_x);
+/* Attaches the visibility buffer to an initialized context, it is cleared with the zbuffer from then on.
+ * Only binds the memory so it can be called every frame, the ids are valid after the next depth clear
+ * (csr_render_clear_screen or csr_render_clear_screen_deferred).
+ * Has to be called again after the context has been (re)initialized.
+ */
+CSR_API CSR_INLINE int csr_visibility_buffer_init(csr_context *context, void *memory, unsigned long memory_size)
+{
+  if (!memory || memory_size < csr_visibility_buffer_size(context->width, context->height))
+  {
+    return 0;
+  }
 
-          /* Depth testing: only draw if the new pixel is closer than the existing one */
-          if (z < context->zbuffer[index])
-          {
-            csr_color pixel_color;
-            pixel_color.r = (unsigned char)current_r;
-            pixel_color.g = (unsigned char)current_g;
-            pixel_color.b = (unsigned char)current_b;
+  context->visibility_buffer = (unsigned int *)memory;
 
-            context->framebuffer[index] = pixel_color;
-            context->zbuffer[index] = z;
-          }
-        }
+  return 1;
+}
 
-        /* Increment barycentric coordinates and colors with pre-calculated deltas */
-        w0 += w0_dx;
-        w1 += w1_dx;
-        w2 += w2_dx;
-        current_r += dr_dx;
-        current_g += dg_dx;
-        current_b += db_dx;
-      }
+/* Returns the primitive id visible at the pixel or CSR_PRIMITIVE_ID_NONE. */
+CSR_API CSR_INLINE unsigned int csr_visibility_buffer_pick(csr_context *context, int x, int y)
+{
+  if (!context->visibility_buffer || x < 0 || y < 0 || x >= context->width || y >= context->height)
+  {
+    return CSR_PRIMITIVE_ID_NONE;
+  }
 
-      /* Reset w values and colors for the start of the next row */
-      w0_start += w0_dy;
-      w1_start += w1_dy;
-      w2_start += w2_dy;
-      r_start += dr_dy;
-      g_start += dg_dy;
-      b_start += db_dy;
+  /* Tiles nothing touched since the last deferred clear still hold the previous ids */
+  if (context->tiles_deferred && context->tiles[(y / CSR_TILE_SIZE) * context->tiles_x + x / CSR_TILE_SIZE] != CSR_TILE_DIRTY)
+  {
+    return CSR_PRIMITIVE_ID_NONE;
+  }
+
+  return context->visibility_buffer[y * context->width + x];
+}
+
+/* #############################################################################
+ * # FRUSTUM CULLING Functions
+ * #############################################################################
+ */
+typedef enum csr_visibility
+{
+  CSR_VISIBILITY_CULLED = 0,      /* Completely outside of the frustum      */
+  CSR_VISIBILITY_INSIDE = 1,      /* Completely inside of the frustum       */
+  CSR_VISIBILITY_INTERSECTING = 2 /* Crosses at least one frustum plane     */
+
+} csr_visibility;
+
+#define CSR_FRUSTUM_PLANE_COUNT 6
+
+/* Extracts the normalized left, right, bottom, top, near and far planes (xyz normal, w distance).
+ * With a projection * view * model matrix the planes are in model space.
+ */
+CSR_API CSR_INLINE void csr_frustum_extract_planes(float planes[CSR_FRUSTUM_PLANE_COUNT * 4], float projection_view_model_matrix[16])
+{
+  float *m = projection_view_model_matrix;
+  int i;
+
+  for (i = 0; i < 4; ++i)
+  {
+    float row3 = m[CSR_M4X4_AT(3, i)];
+
+    planes[0 * 4 + i] = row3 + m[CSR_M4X4_AT(0, i)]; /* left   */
+    planes[1 * 4 + i] = row3 - m[CSR_M4X4_AT(0, i)]; /* right  */
+    planes[2 * 4 + i] = row3 + m[CSR_M4X4_AT(1, i)]; /* bottom */
+    planes[3 * 4 + i] = row3 - m[CSR_M4X4_AT(1, i)]; /* top    */
+    planes[4 * 4 + i] = row3 + m[CSR_M4X4_AT(2, i)]; /* near   */
+    planes[5 * 4 + i] = row3 - m[CSR_M4X4_AT(2, i)]; /* far    */
+  }
+
+  for (i = 0; i < CSR_FRUSTUM_PLANE_COUNT; ++i)
+  {
+    float *p = &planes[i * 4];
+    float scalar = csr_invsqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+
+    p[0] *= scalar;
+    p[1] *= scalar;
+    p[2] *= scalar;
+    p[3] *= scalar;
+  }
+}
+
+/* Classifies a sphere (center xyz, radius w) against the frustum planes. */
+CSR_API CSR_INLINE csr_visibility csr_frustum_test_sphere(float planes[CSR_FRUSTUM_PLANE_COUNT * 4], float sphere[4])
+{
+  csr_visibility result = CSR_VISIBILITY_INSIDE;
+  int i;
+
+  for (i = 0; i < CSR_FRUSTUM_PLANE_COUNT; ++i)
+  {
+    float *p = &planes[i * 4];
+    float distance = p[0] * sphere[0] + p[1] * sphere[1] + p[2] * sphere[2] + p[3];
+
+    if (distance < -sphere[3])
+    {
+      return CSR_VISIBILITY_CULLED;
+    }
+
+    if (distance < sphere[3])
+    {
+      result = CSR_VISIBILITY_INTERSECTING;
     }
   }
+
+  return result;
 }
 
-CSR_API CSR_INLINE void csr_render(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_model_matrix[16])
+/* Same as csr_render but skips the whole mesh if its model space bounding sphere is outside of the frustum.
+ * Returns the visibility of the mesh, a bounding_sphere of 0 always renders and reports CSR_VISIBILITY_INTERSECTING.
+ */
+CSR_API CSR_INLINE csr_visibility csr_render_bounded(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_model_matrix[16], float bounding_sphere[4])
+{
+  csr_visibility visibility = CSR_VISIBILITY_INTERSECTING;
+
+  if (bounding_sphere)
+  {
+    float planes[CSR_FRUSTUM_PLANE_COUNT * 4];
+
+    csr_frustum_extract_planes(planes, projection_view_model_matrix);
+    visibility = csr_frustum_test_sphere(planes, bounding_sphere);
+  }
+
+  /* Meshes completely inside of the frustum skip the clipping stage */
+  if (visibility != CSR_VISIBILITY_CULLED)
+  {
+    csr_render_triangles(context, render_mode, culling_mode, stride, vertices, num_vertices, indices, num_indices, projection_view_model_matrix, visibility != CSR_VISIBILITY_INSIDE);
+  }
+
+  return visibility;
+}
+
+/* Computes a bounding sphere (center xyz, radius w) of all vertices referenced by the index buffer.
+ * The result can be cached per mesh and passed to csr_queue_submit.
+ */
+CSR_API CSR_INLINE void csr_bounding_sphere(float result[4], int stride, float *vertices, int *indices, unsigned long num_indices)
 {
+  float min_x = 1e30f, min_y = 1e30f, min_z = 1e30f;
+  float max_x = -1e30f, max_y = -1e30f, max_z = -1e30f;
+  float radius_squared = 0.0f;
   unsigned long i;
 
-  (void)num_vertices;
+  csr_pos_init(result, 0.0f, 0.0f, 0.0f, 0.0f);
 
-  for (i = 0; i < num_indices; i += 3)
+  if (num_indices == 0)
   {
-    /* Get vertex indices for the current triangle */
-    int i0 = indices[i];
-    int i1 = indices[i + 1];
-    int i2 = indices[i + 2];
+    return;
+  }
 
-    /* Get the vertex data from the main vertex array using the indices, and convert to homogeneous coordinates */
-    float pos0[4];
-    float pos1[4];
-    float pos2[4];
+  /* Center of the axis aligned bounding box */
+  for (i = 0; i < num_indices; ++i)
+  {
+    float *v = &vertices[indices[i] * stride];
+
+    min_x = csr_minf(min_x, v[0]);
+    min_y = csr_minf(min_y, v[1]);
+    min_z = csr_minf(min_z, v[2]);
+    max_x = csr_maxf(max_x, v[0]);
+    max_y = csr_maxf(max_y, v[1]);
+    max_z = csr_maxf(max_z, v[2]);
+  }
 
-    /* 1. Vertex Processing (Model, View, Projection) */
-    float v0_transformed[4];
-    float v1_transformed[4];
-    float v2_transformed[4];
+  result[0] = (min_x + max_x) * 0.5f;
+  result[1] = (min_y + max_y) * 0.5f;
+  result[2] = (min_z + max_z) * 0.5f;
 
-    float v0_ndc[4];
-    float v1_ndc[4];
-    float v2_ndc[4];
+  /* Radius is the farthest vertex from that center */
+  for (i = 0; i < num_indices; ++i)
+  {
+    float *v = &vertices[indices[i] * stride];
+    float dx = v[0] - result[0];
+    float dy = v[1] - result[1];
+    float dz = v[2] - result[2];
 
-    float v0_screen[3];
-    float v1_screen[3];
-    float v2_screen[3];
+    radius_squared = csr_maxf(radius_squared, dx * dx + dy * dy + dz * dz);
+  }
 
-    csr_pos_init(pos0, vertices[i0 * stride + 0], vertices[i0 * stride + 1], vertices[i0 * stride + 2], 1.0f);
-    csr_pos_init(pos1, vertices[i1 * stride + 0], vertices[i1 * stride + 1], vertices[i1 * stride + 2], 1.0f);
-    csr_pos_init(pos2, vertices[i2 * stride + 0], vertices[i2 * stride + 1], vertices[i2 * stride + 2], 1.0f);
+  /* Pad slightly since csr_sqrtf is an approximation */
+  result[3] = csr_sqrtf(radius_squared) * 1.01f;
+}
 
-    csr_m4x4_mul_v4(v0_transformed, projection_view_model_matrix, pos0);
-    csr_m4x4_mul_v4(v1_transformed, projection_view_model_matrix, pos1);
-    csr_m4x4_mul_v4(v2_transformed, projection_view_model_matrix, pos2);
+/* #############################################################################
+ * # INSTANCING Functions
+ * #############################################################################
+ *
+ * Renders one mesh with many model matrices. Every instance is culled by its bounding sphere and the
+ * vertices of visible instances are transformed once into a clip space cache instead of once per
+ * referencing triangle. Without a cache (see csr_instance_init) instances fall back to csr_render_bounded.
+ *
+ * As for csr_render num_vertices is the number of floats in vertices, the mesh has num_vertices / stride vertices.
+ */
+CSR_API CSR_INLINE unsigned long csr_instance_memory_size(int stride, unsigned long num_vertices)
+{
+  /* Padding for the 16 byte alignment of the cache */
+  return (num_vertices / (unsigned long)stride) * 4 * sizeof(float) + 16;
+}
+
+CSR_API CSR_INLINE int csr_instance_init(csr_context *context, void *memory, unsigned long memory_size)
+{
+  unsigned long padding = (16 - ((unsigned long)memory & 15)) & 15;
+
+  if (!memory || memory_size < padding + 4 * sizeof(float))
+  {
+    return 0;
+  }
 
-    /* Check if the triangle is behind the camera (clipping) */
-    if (v0_transformed[3] <= 0.0f || v1_transformed[3] <= 0.0f || v2_transformed[3] <= 0.0f)
+  context->instance_vertices = (float *)(void *)((unsigned char *)memory + padding);
+  context->instance_vertices_capacity = (memory_size - padding) / (4 * sizeof(float));
+
+  return 1;
+}
+
+/* Transforms the positions of count vertices into 4 floats each, the matrix stays in registers for the whole batch */
+CSR_API CSR_INLINE void csr_transform_vertices(float *result, float m[16], int stride, float *vertices, unsigned long count)
+{
+  unsigned long i;
+
+#ifdef CSR_USE_SSE
+  __m128 col0 = _mm_loadu_ps(&m[CSR_M4X4_AT(0, 0)]);
+  __m128 col1 = _mm_loadu_ps(&m[CSR_M4X4_AT(0, 1)]);
+  __m128 col2 = _mm_loadu_ps(&m[CSR_M4X4_AT(0, 2)]);
+  __m128 col3 = _mm_loadu_ps(&m[CSR_M4X4_AT(0, 3)]);
+
+  for (i = 0; i < count; ++i)
+  {
+    float *v = &vertices[i * (unsigned long)stride];
+    __m128 res = _mm_mul_ps(col0, _mm_set1_ps(v[0]));
+    res = _mm_add_ps(res, _mm_mul_ps(col1, _mm_set1_ps(v[1])));
+    res = _mm_add_ps(res, _mm_mul_ps(col2, _mm_set1_ps(v[2])));
+    res = _mm_add_ps(res, col3);
+
+    _mm_store_ps(&result[i * 4], res);
+  }
+#else
+  float m00 = m[CSR_M4X4_AT(0, 0)], m01 = m[CSR_M4X4_AT(0, 1)], m02 = m[CSR_M4X4_AT(0, 2)], m03 = m[CSR_M4X4_AT(0, 3)];
+  float m10 = m[CSR_M4X4_AT(1, 0)], m11 = m[CSR_M4X4_AT(1, 1)], m12 = m[CSR_M4X4_AT(1, 2)], m13 = m[CSR_M4X4_AT(1, 3)];
+  float m20 = m[CSR_M4X4_AT(2, 0)], m21 = m[CSR_M4X4_AT(2, 1)], m22 = m[CSR_M4X4_AT(2, 2)], m23 = m[CSR_M4X4_AT(2, 3)];
+  float m30 = m[CSR_M4X4_AT(3, 0)], m31 = m[CSR_M4X4_AT(3, 1)], m32 = m[CSR_M4X4_AT(3, 2)], m33 = m[CSR_M4X4_AT(3, 3)];
+
+  for (i = 0; i < count; ++i)
+  {
+    float *v = &vertices[i * (unsigned long)stride];
+    float *r = &result[i * 4];
+
+    r[0] = m00 * v[0] + m01 * v[1] + m02 * v[2] + m03;
+    r[1] = m10 * v[0] + m11 * v[1] + m12 * v[2] + m13;
+    r[2] = m20 * v[0] + m21 * v[1] + m22 * v[2] + m23;
+    r[3] = m30 * v[0] + m31 * v[1] + m32 * v[2] + m33;
+  }
+#endif
+}
+
+/* Renders instance_count copies of a mesh, model_matrices holds 16 floats per instance.
+ * The bounding sphere is in model space and shared by all instances, 0 disables instance culling.
+ * Returns the number of instances that were not culled.
+ */
+CSR_API CSR_INLINE unsigned long csr_render_instanced(csr_context *context, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_matrix[16], float *model_matrices, unsigned long instance_count, float bounding_sphere[4])
+{
+  unsigned long visible = 0;
+  unsigned long instance;
+  unsigned long vertex_count = num_vertices / (unsigned long)stride;
+  int cached = render_mode != CSR_RENDER_LINES && context->instance_vertices && vertex_count <= context->instance_vertices_capacity;
+
+  /* Without the vertex cache every instance is a timed csr_render_bounded call */
+  CSR_STATS_ONLY(double stats_start = cached && context->stats ? csr_stats_time() : 0.0;)
+
+  for (instance = 0; instance < instance_count; ++instance)
+  {
+    float projection_view_model_matrix[16];
+    csr_visibility visibility = CSR_VISIBILITY_INTERSECTING;
+    unsigned long i;
+
+    csr_m4x4_mul(projection_view_model_matrix, projection_view_matrix, &model_matrices[instance * 16]);
+
+    if (!cached)
     {
+      visible += csr_render_bounded(context, render_mode, culling_mode, stride, vertices, num_vertices, indices, num_indices, projection_view_model_matrix, bounding_sphere) != CSR_VISIBILITY_CULLED;
       continue;
     }
 
-    /* 2. Perspective Divide (Clip Space to NDC) */
-    csr_v4_divf(v0_ndc, v0_transformed, v0_transformed[3]);
-    csr_v4_divf(v1_ndc, v1_transformed, v1_transformed[3]);
-    csr_v4_divf(v2_ndc, v2_transformed, v2_transformed[3]);
+    if (bounding_sphere)
+    {
+      float planes[CSR_FRUSTUM_PLANE_COUNT * 4];
 
-    /* 3. Viewport Transform (NDC to Screen Space) */
-    csr_ndc_to_screen(context, v0_screen, v0_ndc);
-    csr_ndc_to_screen(context, v1_screen, v1_ndc);
-    csr_ndc_to_screen(context, v2_screen, v2_ndc);
+      csr_frustum_extract_planes(planes, projection_view_model_matrix);
+      visibility = csr_frustum_test_sphere(planes, bounding_sphere);
+    }
+
+    if (visibility == CSR_VISIBILITY_CULLED)
+    {
+      continue;
+    }
+
+    visible++;
+
+    CSR_STATS_ADD(context, triangles_submitted, num_indices / 3);
+
+    csr_primitive_id_check(context, num_indices / 3);
+    csr_transform_vertices(context->instance_vertices, projection_view_model_matrix, stride, vertices, vertex_count);
 
-    /* 4. Culling based on winding order */
-    if (culling_mode != CSR_CULLING_DISABLED)
+    for (i = 0; i < num_indices; i += 3)
     {
-      float ax = v1_screen[0] - v0_screen[0];
-      float ay = v1_screen[1] - v0_screen[1];
-      float bx = v2_screen[0] - v0_screen[0];
-      float by = v2_screen[1] - v0_screen[1];
-      float face = ax * by - ay * bx;
+      int i0 = indices[i];
+      int i1 = indices[i + 1];
+      int i2 = indices[i + 2];
+      float *cache = context->instance_vertices;
+
+      context->primitive_id = csr_primitive_id(context->draw_id, i / 3);
+
+      csr_render_transformed_triangle(context, render_mode, culling_mode, stride, vertices, i0, i1, i2, &cache[i0 * 4], &cache[i1 * 4], &cache[i2 * 4], visibility != CSR_VISIBILITY_INSIDE);
+    }
+  }
+
+#ifdef CSR_STATS
+  if (cached && context->stats)
+  {
+    context->stats->render_time += csr_stats_time() - stats_start;
+  }
+#endif
+
+  return visible;
+}
+
+/* #############################################################################
+ * # RENDER QUEUE Functions
+ * #############################################################################
+ *
+ * Collects draws for one frame and executes them in a single flush.
+ * Solid draws are executed first and sorted front to back by the depth of their
+ * bounding sphere so that the depth test rejects occluded pixels early.
+ * Wireframe draws are grouped after the solid draws.
+ * Draws with a bounding sphere outside of the frustum are culled on flush.
+ */
+typedef struct csr_queue_item
+{
+  csr_render_mode render_mode;
+  csr_culling_mode culling_mode;
+  int stride;
+  float *vertices;
+  unsigned long num_vertices;
+  int *indices;
+  unsigned long num_indices;
+  float projection_view_model_matrix[16];
+  float bounding_sphere[4];  /* model space center xyz, radius w       */
+  float sort_depth;          /* clip space depth of the sphere center  */
+  csr_visibility visibility; /* frustum test result of the last flush  */
+
+} csr_queue_item;
+
+typedef struct csr_queue
+{
+  csr_queue_item *items;  /* memory pointer for submitted items    */
+  unsigned long *order;   /* memory pointer for sorted item order  */
+  unsigned long capacity; /* maximum number of items per flush     */
+  unsigned long count;    /* number of items submitted             */
+  unsigned long visible;  /* number of items not culled on flush   */
+
+  unsigned long visibility_counts[3]; /* draws of the last flush per csr_visibility */
+
+} csr_queue;
+
+CSR_API CSR_INLINE unsigned long csr_queue_memory_size(unsigned long capacity)
+{
+  return (unsigned long)(capacity * (unsigned long)sizeof(csr_queue_item) + /* items size */
+                         capacity * (unsigned long)sizeof(unsigned long)    /* order size */
+  );
+}
+
+CSR_API CSR_INLINE int csr_queue_init(csr_queue *queue, void *memory, unsigned long memory_size, unsigned long capacity)
+{
+  if (memory_size < csr_queue_memory_size(capacity))
+  {
+    return 0;
+  }
+
+  queue->items = (csr_queue_item *)memory;
+  queue->order = (unsigned long *)((char *)memory + capacity * (unsigned long)sizeof(csr_queue_item));
+  queue->capacity = capacity;
+  queue->count = 0;
+  queue->visible = 0;
+  queue->visibility_counts[CSR_VISIBILITY_CULLED] = 0;
+  queue->visibility_counts[CSR_VISIBILITY_INSIDE] = 0;
+  queue->visibility_counts[CSR_VISIBILITY_INTERSECTING] = 0;
+
+  return 1;
+}
+
+/* Adds a draw to the queue. The vertex/index memory must stay valid until csr_queue_flush.
+ * bounding_sphere (center xyz, radius w) is in model space and may be 0 in which case the model origin is used
+ * for sorting and the draw is never culled.
+ * Returns 0 if the queue is full.
+ */
+CSR_API CSR_INLINE int csr_queue_submit(csr_queue *queue, csr_render_mode render_mode, csr_culling_mode culling_mode, int stride, float *vertices, unsigned long num_vertices, int *indices, unsigned long num_indices, float projection_view_model_matrix[16], float bounding_sphere[4])
+{
+  csr_queue_item *item;
+  float center[4];
+  float center_clip[4];
+  int i;
+
+  if (queue->count >= queue->capacity)
+  {
+    return 0;
+  }
+
+  item = &queue->items[queue->count];
+  item->render_mode = render_mode;
+  item->culling_mode = culling_mode;
+  item->stride = stride;
+  item->vertices = vertices;
+  item->num_vertices = num_vertices;
+  item->indices = indices;
+  item->num_indices = num_indices;
+
+  for (i = 0; i < 16; ++i)
+  {
+    item->projection_view_model_matrix[i] = projection_view_model_matrix[i];
+  }
+
+  /* Clip space z grows monotonically with the view distance for perspective and orthographic projections */
+  if (bounding_sphere)
+  {
+    csr_pos_init(item->bounding_sphere, bounding_sphere[0], bounding_sphere[1], bounding_sphere[2], bounding_sphere[3]);
+    csr_pos_init(center, bounding_sphere[0], bounding_sphere[1], bounding_sphere[2], 1.0f);
+  }
+  else
+  {
+    /* Negative radius marks a draw without bounds which is never culled */
+    csr_pos_init(item->bounding_sphere, 0.0f, 0.0f, 0.0f, -1.0f);
+    csr_pos_init(center, 0.0f, 0.0f, 0.0f, 1.0f);
+  }
+
+  csr_m4x4_mul_v4(center_clip, item->projection_view_model_matrix, center);
+  item->sort_depth = center_clip[2];
+
+  queue->count++;
+
+  return 1;
+}
+
+/* Returns 1 if item a has to be executed before item b */
+CSR_API CSR_INLINE int csr_queue_item_before(csr_queue_item *a, csr_queue_item *b)
+{
+  /* Solid draws first (lit and unlit together), line draws grouped by mode after them */
+  int mode_a = a->render_mode == CSR_RENDER_LIT ? CSR_RENDER_SOLID : (int)a->render_mode;
+  int mode_b = b->render_mode == CSR_RENDER_LIT ? CSR_RENDER_SOLID : (int)b->render_mode;
+
+  if (mode_a != mode_b)
+  {
+    return mode_a < mode_b;
+  }
+
+  return a->sort_depth < b->sort_depth;
+}
 
-      int is_ccw_face = (face >= 0.0f);
-      int is_cw_face = (face <= 0.0f);
+CSR_API CSR_INLINE void csr_queue_sort(csr_queue *queue)
+{
+  unsigned long gap;
 
-      int should_cull = 0;
+  /* Shell sort over the visible order indices, items themselves are never moved */
+  for (gap = queue->visible / 2; gap > 0; gap /= 2)
+  {
+    unsigned long i;
 
-      should_cull |= (culling_mode == CSR_CULLING_CCW_BACKFACE) & is_cw_face;
-      should_cull |= (culling_mode == CSR_CULLING_CCW_FRONTFACE) & is_ccw_face;
-      should_cull |= (culling_mode == CSR_CULLING_CW_BACKFACE) & is_ccw_face;
-      should_cull |= (culling_mode == CSR_CULLING_CW_FRONTFACE) & is_cw_face;
+    for (i = gap; i < queue->visible; ++i)
+    {
+      unsigned long current = queue->order[i];
+      unsigned long j = i;
 
-      if (should_cull)
+      while (j >= gap && csr_queue_item_before(&queue->items[current], &queue->items[queue->order[j - gap]]))
       {
-        continue;
+        queue->order[j] = queue->order[j - gap];
+        j -= gap;
       }
+
+      queue->order[j] = current;
     }
+  }
+}
+
+/* Frustum culls the submitted items and collects the visible ones into the order indices. */
+CSR_API CSR_INLINE void csr_queue_cull(csr_queue *queue)
+{
+  unsigned long i;
 
-    /* 5. Rasterization & Depth Testing */
-    if (render_mode == CSR_RENDER_SOLID)
+  queue->visible = 0;
+  queue->visibility_counts[CSR_VISIBILITY_CULLED] = 0;
+  queue->visibility_counts[CSR_VISIBILITY_INSIDE] = 0;
+  queue->visibility_counts[CSR_VISIBILITY_INTERSECTING] = 0;
+
+  for (i = 0; i < queue->count; ++i)
+  {
+    csr_queue_item *item = &queue->items[i];
+    csr_visibility visibility = CSR_VISIBILITY_INTERSECTING;
+
+    if (item->bounding_sphere[3] >= 0.0f)
     {
-      csr_color color0 = stride == 3 ? csr_init_color(255, 50, 50) : csr_init_color((unsigned char)vertices[i0 * stride + 3], (unsigned char)vertices[i0 * stride + 4], (unsigned char)vertices[i0 * stride + 5]);
-      csr_color color1 = stride == 3 ? csr_init_color(50, 255, 50) : csr_init_color((unsigned char)vertices[i1 * stride + 3], (unsigned char)vertices[i1 * stride + 4], (unsigned char)vertices[i1 * stride + 5]);
-      csr_color color2 = stride == 3 ? csr_init_color(50, 50, 255) : csr_init_color((unsigned char)vertices[i2 * stride + 3], (unsigned char)vertices[i2 * stride + 4], (unsigned char)vertices[i2 * stride + 5]);
+      float planes[CSR_FRUSTUM_PLANE_COUNT * 4];
 
-      csr_draw_triangle(context, v0_screen, v1_screen, v2_screen, color0, color1, color2);
+      csr_frustum_extract_planes(planes, item->projection_view_model_matrix);
+      visibility = csr_frustum_test_sphere(planes, item->bounding_sphere);
     }
-    else
-    {
-      csr_color color0 = stride == 3 ? csr_init_color(255, 50, 50) : csr_init_color((unsigned char)vertices[i0 * stride + 3], (unsigned char)vertices[i0 * stride + 4], (unsigned char)vertices[i0 * stride + 5]);
 
-      csr_draw_line(context, v0_screen, v1_screen, color0);
-      csr_draw_line(context, v1_screen, v2_screen, color0);
-      csr_draw_line(context, v2_screen, v0_screen, color0);
+    item->visibility = visibility;
+    queue->visibility_counts[visibility]++;
+
+    if (visibility != CSR_VISIBILITY_CULLED)
+    {
+      queue->order[queue->visible++] = i;
     }
   }
 }
 
+/* Culls, sorts and renders all submitted items and empties the queue.
+ * Each draw uses its submission index as draw id, context->draw_id is left at the last one.
+ * Draws submitted after the first CSR_DRAW_ID_MAX + 1 can not be picked, see csr_primitive_id.
+ */
+CSR_API CSR_INLINE void csr_queue_flush(csr_context *context, csr_queue *queue)
+{
+  unsigned long i;
+
+  csr_queue_cull(queue);
+  csr_queue_sort(queue);
+
+  for (i = 0; i < queue->visible; ++i)
+  {
+    csr_queue_item *item = &queue->items[queue->order[i]];
+
+    /* The submission index identifies the draw in the visibility buffer */
+    context->draw_id = (unsigned int)queue->order[i];
+
+    csr_render_triangles(
+        context,
+        item->render_mode,
+        item->culling_mode,
+        item->stride,
+        item->vertices, item->num_vertices,
+        item->indices, item->num_indices,
+        item->projection_view_model_matrix,
+        item->visibility != CSR_VISIBILITY_INSIDE);
+  }
+
+  queue->count = 0;
+}
+
 #endif /* CSR_H */
 
 /*
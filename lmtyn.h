@@ -29,6 +29,7 @@ LICENSE
 #define LMTYN_API static
 
 typedef unsigned char u8;
+typedef unsigned short u16;
 typedef unsigned int u32;
 typedef int i32;
 typedef float f32;
@@ -36,6 +37,7 @@ typedef float f32;
 #define LMTYN_STATIC_ASSERT(c, m) typedef char lmtyn_assert_##m[(c) ? 1 : -1]
 
 LMTYN_STATIC_ASSERT(sizeof(u8) == 1, u8_size_must_be_1);
+LMTYN_STATIC_ASSERT(sizeof(u16) == 2, u16_size_must_be_2);
 LMTYN_STATIC_ASSERT(sizeof(u32) == 4, u32_size_must_be_4);
 LMTYN_STATIC_ASSERT(sizeof(i32) == 4, i32_size_must_be_4);
 LMTYN_STATIC_ASSERT(sizeof(f32) == 4, f32_size_must_be_4);
@@ -61,7 +63,7 @@ LMTYN_API LMTYN_INLINE f32 lmtyn_invsqrt(f32 number)
   union
   {
     f32 f;
-    long i;
+    i32 i;
   } conv;
 
   f32 x2, y;
@@ -312,11 +314,26 @@ typedef struct lmtyn_mesh
   u32 indices_capacity;
   u32 indices_size;
 
+  /* Optional unique edge list, two vertex indices per edge.
+   * Only filled by lmtyn_mesh_generate if edges is set.
+   */
+  u32 edges_capacity;
+  u32 edges_size;
+
   f32 *vertices;
   u32 *indices;
+  u32 *edges;
 
 } lmtyn_mesh;
 
+/* does the last circle connects with the first one? */
+LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_is_closed(lmtyn_shape_circle *circles, u32 circles_count)
+{
+  return (u8)(circles[0].center_x == circles[circles_count - 1].center_x &&
+              circles[0].center_y == circles[circles_count - 1].center_y &&
+              circles[0].center_z == circles[circles_count - 1].center_z);
+}
+
 LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_generate(
     lmtyn_mesh *mesh,
     u8 winding_cw,
@@ -324,7 +341,7 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_generate(
     u32 circles_count,
     u32 segments)
 {
-  u32 i, c, s, v;
+  u32 i, c, s, v, e;
   u32 bottomCenterIndex, topCenterIndex, topStart;
   lmtyn_v3 center, tangent, normal, prevNormal, U, V;
   f32 radius;
@@ -337,10 +354,7 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_generate(
     return 0;
   }
 
-  /* does the last circle connects with the first one? */
-  is_closed = (circles[0].center_x == circles[circles_count - 1].center_x &&
-               circles[0].center_y == circles[circles_count - 1].center_y &&
-               circles[0].center_z == circles[circles_count - 1].center_z);
+  is_closed = lmtyn_mesh_is_closed(circles, circles_count);
 
   /* precompute sizes */
   if (is_closed)
@@ -354,8 +368,13 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_generate(
     mesh->indices_size = (circles_count - 1) * segments * 6 + segments * 6;
   }
 
+  /* ring edges of every circle, longitudinal and diagonal edges of every side quad, spokes of both caps */
+  circleCountWrapped = is_closed ? circles_count : circles_count - 1;
+  mesh->edges_size = mesh->edges ? (circles_count * segments + circleCountWrapped * segments * 2 + (is_closed ? 0 : segments * 2)) * 2 : 0;
+
   if (mesh->vertices_capacity < sizeof(f32) * mesh->vertices_size ||
-      mesh->indices_capacity < sizeof(u32) * mesh->indices_size)
+      mesh->indices_capacity < sizeof(u32) * mesh->indices_size ||
+      mesh->edges_capacity < sizeof(u32) * mesh->edges_size)
   {
     return 0;
   }
@@ -455,8 +474,6 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_generate(
   }
 
   /* sides */
-  circleCountWrapped = is_closed ? circles_count : circles_count - 1;
-
   for (c = 0; c < circleCountWrapped; ++c)
   {
     u32 nextCircle = (c + 1) % circles_count; /* wrap to first circle */
@@ -500,22 +517,108 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_generate(
     }
   }
 
-  return v == mesh->vertices_size && i == mesh->indices_size;
+  /* unique edges, each edge shared by two triangles is emitted once (segments >= 3) */
+  e = 0;
+
+  if (mesh->edges)
+  {
+    for (c = 0; c < circles_count; ++c)
+    {
+      for (s = 0; s < segments; ++s)
+      {
+        u32 curr = c * segments + s;
+        u32 nextCircle = (c + 1) % circles_count;
+
+        /* ring */
+        mesh->edges[e++] = curr;
+        mesh->edges[e++] = c * segments + (s + 1) % segments;
+
+        if (c < circleCountWrapped)
+        {
+          /* longitudinal */
+          mesh->edges[e++] = curr;
+          mesh->edges[e++] = nextCircle * segments + s;
+
+          /* diagonal of the side quad */
+          mesh->edges[e++] = curr;
+          mesh->edges[e++] = nextCircle * segments + (s + 1) % segments;
+        }
+      }
+    }
+
+    if (!is_closed)
+    {
+      /* cap spokes */
+      for (s = 0; s < segments; ++s)
+      {
+        mesh->edges[e++] = bottomCenterIndex;
+        mesh->edges[e++] = s;
+        mesh->edges[e++] = topCenterIndex;
+        mesh->edges[e++] = (circles_count - 1) * segments + s;
+      }
+    }
+  }
+
+  return v == mesh->vertices_size && i == mesh->indices_size && e == mesh->edges_size;
 }
 
-LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_normalize(
+/* Maps a triangle index of a mesh generated by lmtyn_mesh_generate back to the circle and segment it was
+ * generated from. Side triangles belong to the circle their quad starts at, cap triangles to the first or
+ * last circle. Returns 0 if the triangle index is out of range.
+ */
+LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_triangle_source(
+    lmtyn_shape_circle *circles,
+    u32 circles_count,
+    u32 segments,
+    u32 triangle,
+    u32 *circle,
+    u32 *segment)
+{
+  u8 is_closed;
+  u32 side_triangles;
+
+  if (!circles || circles_count == 0 || segments == 0)
+  {
+    return 0;
+  }
+
+  is_closed = lmtyn_mesh_is_closed(circles, circles_count);
+  side_triangles = (is_closed ? circles_count : circles_count - 1) * segments * 2;
+
+  /* sides, two triangles per segment quad */
+  if (triangle < side_triangles)
+  {
+    *circle = (triangle / 2) / segments;
+    *segment = (triangle / 2) % segments;
+    return 1;
+  }
+
+  triangle -= side_triangles;
+
+  if (is_closed || triangle >= segments * 2)
+  {
+    return 0;
+  }
+
+  /* bottom cap, then top cap */
+  *circle = triangle < segments ? 0 : circles_count - 1;
+  *segment = triangle % segments;
+
+  return 1;
+}
+
+/* Center and largest extent of the axis aligned bounding box of the mesh vertices.
+ * Returns 0 for empty or degenerated meshes.
+ */
+LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_bounds(
     lmtyn_mesh *mesh,
-    f32 target_x,
-    f32 target_y,
-    f32 target_z,
-    f32 targetSize)
+    f32 center[3],
+    f32 *size)
 {
   f32 min_x = 1e9f, min_y = 1e9f, min_z = 1e9f;
   f32 max_x = -1e9f, max_y = -1e9f, max_z = -1e9f;
 
   u32 i;
-  f32 scale = 1.0f;
-  f32 center_x, center_y, center_z;
   f32 size_x, size_y, size_z;
   f32 size_max;
 
@@ -524,12 +627,12 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_normalize(
     return 0;
   }
 
-  /* Compute bounding box */
-  for (i = 0; i < mesh->vertices_size; ++i)
+  /* Compute bounding box, vertices_size counts floats (3 per vertex) */
+  for (i = 0; i + 2 < mesh->vertices_size; i += 3)
   {
-    f32 x = mesh->vertices[i * 3 + 0];
-    f32 y = mesh->vertices[i * 3 + 1];
-    f32 z = mesh->vertices[i * 3 + 2];
+    f32 x = mesh->vertices[i + 0];
+    f32 y = mesh->vertices[i + 1];
+    f32 z = mesh->vertices[i + 2];
 
     min_x = (x < min_x) ? x : min_x;
     min_y = (y < min_y) ? y : min_y;
@@ -541,9 +644,9 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_normalize(
   }
 
   /* Compute center and size */
-  center_x = (min_x + max_x) * 0.5f;
-  center_y = (min_y + max_y) * 0.5f;
-  center_z = (min_z + max_z) * 0.5f;
+  center[0] = (min_x + max_x) * 0.5f;
+  center[1] = (min_y + max_y) * 0.5f;
+  center[2] = (min_z + max_z) * 0.5f;
 
   size_x = max_x - min_x;
   size_y = max_y - min_y;
@@ -553,21 +656,43 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_normalize(
   size_max = (size_y > size_max) ? size_y : size_max;
   size_max = (size_z > size_max) ? size_z : size_max;
 
-  if (size_max < 1e-6f)
+  *size = size_max;
+
+  return size_max >= 1e-6f; /* prevent divide by zero */
+}
+
+LMTYN_API LMTYN_INLINE u8 lmtyn_mesh_normalize(
+    lmtyn_mesh *mesh,
+    f32 target_x,
+    f32 target_y,
+    f32 target_z,
+    f32 targetSize)
+{
+  u32 i;
+  f32 scale = 1.0f;
+  f32 center[3];
+  f32 center_x, center_y, center_z;
+  f32 size_max;
+
+  if (!lmtyn_mesh_bounds(mesh, center, &size_max))
   {
-    return 0; /* prevent divide by zero */
+    return 0;
   }
 
-  if (targetSize > 0.0f && size_max > 1e-6f)
+  center_x = center[0];
+  center_y = center[1];
+  center_z = center[2];
+
+  if (targetSize > 0.0f)
   {
     scale = targetSize / size_max;
   }
 
   /* Apply normalization (translate + scale) */
-  for (i = 0; i < mesh->vertices_size; ++i)
+  for (i = 0; i + 2 < mesh->vertices_size; i += 3)
   {
     /* move to origin first, then scale, then move to target */
-    f32 *v = &mesh->vertices[i * 3];
+    f32 *v = &mesh->vertices[i];
 
     v[0] = (v[0] - center_x) * scale + target_x;
     v[1] = (v[1] - center_y) * scale + target_y;
@@ -4,6 +4,26 @@
 #include "lmtyn.h"    /* The main modelling algorithm    */
 #include "deps/csr.h" /* 3D Software Renderer            */
 #include "deps/vm.h"  /* 3D Linear Algebra / Vector Math */
+#include "deps/perf.h" /* Timing of the 3D preview       */
+
+/* The 3D view blit follows the SSE setting of csr and uses its integer (SSE2) instructions */
+#if defined(CSR_USE_SSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LMTYN_EDITOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Counters shared by the editor and the mesh worker thread, loads acquire and stores release.
+ * MSVC gives volatile accesses these semantics on x86/x64 (/volatile:ms).
+ */
+#ifndef LMTYN_EDITOR_LOAD_ACQUIRE
+#if defined(__GNUC__) || defined(__clang__)
+#define LMTYN_EDITOR_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define LMTYN_EDITOR_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define LMTYN_EDITOR_LOAD_ACQUIRE(p) (*(p))
+#define LMTYN_EDITOR_STORE_RELEASE(p, v) (*(p) = (v))
+#endif
+#endif
 
 /* contains some general fields relevant for all ui elements */
 typedef struct lmtyn_editor_ui_header
@@ -50,6 +70,24 @@ typedef enum lmtyn_editor_regions
 
 } lmtyn_editor_regions;
 
+/* Everything the background and grid of a 2D view depend on */
+typedef struct lmtyn_editor_grid_key
+{
+    u32 x;
+    u32 y;
+    u32 w;
+    u32 h;
+    u32 stride;
+    u32 color_background;
+    u32 color;
+    u32 color_axis;
+    f32 scale;
+    f32 cell_size;
+    f32 scroll_offset_x;
+    f32 scroll_offset_y;
+
+} lmtyn_editor_grid_key;
+
 typedef struct lmtyn_editor_region
 {
     u32 x;
@@ -62,8 +100,140 @@ typedef struct lmtyn_editor_region
     f32 grid_scroll_offset_x;
     f32 grid_scroll_offset_y;
 
+    lmtyn_editor_grid_key grid_cache_key; /* view the cached grid layer was drawn for */
+    u8 grid_cached;
+
+    u32 signature; /* hash of everything drawn into the region last frame */
+    u8 dirty;      /* the region is redrawn (and has to be presented) this frame */
+
 } lmtyn_editor_region;
 
+typedef struct lmtyn_editor_rect
+{
+    u32 x;
+    u32 y;
+    u32 w;
+    u32 h;
+
+} lmtyn_editor_rect;
+
+/* Platform threads for lmtyn_editor_render, runs job(job_data[i]) for every i < job_count
+ * (in any order and possibly in parallel) and returns once all of them finished.
+ */
+typedef void (*lmtyn_editor_job)(void *job_data);
+typedef void (*lmtyn_editor_jobs_run)(void *jobs_context, lmtyn_editor_job job, void **job_data, u32 job_count);
+
+/* Snapshots of the circles the editor can post before the mesh worker took them, a power of two */
+#define LMTYN_EDITOR_MESH_QUEUE_SIZE 2
+
+typedef struct lmtyn_editor_mesh_snapshot
+{
+    lmtyn_shape_circle *circles;
+    u32 circles_count;
+    u32 mesh_segments;
+
+} lmtyn_editor_mesh_snapshot;
+
+/* Generates the mesh on a platform thread, see lmtyn_editor_mesh_worker_init.
+ * Single producer (the editor) and single consumer (the worker): only the editor writes snapshots_write
+ * and clears mesh_ready, only the worker writes snapshots_read and sets mesh_ready.
+ */
+typedef struct lmtyn_editor_mesh_worker
+{
+    lmtyn_editor_mesh_snapshot snapshots[LMTYN_EDITOR_MESH_QUEUE_SIZE];
+    volatile u32 snapshots_write; /* snapshots posted by the editor                   */
+    volatile u32 snapshots_read;  /* snapshots taken by the worker                    */
+    volatile u32 mesh_ready;      /* mesh is complete and waits for the editor        */
+    lmtyn_mesh mesh;              /* back buffer, swapped with the mesh of the editor */
+    u32 model;                    /* hash of the last posted circles                  */
+
+    /* Called after the editor posted a snapshot or took the mesh. The platform thread then calls
+     * lmtyn_editor_mesh_worker_process until it returns 0.
+     */
+    void (*wake)(void *wake_context);
+    void *wake_context;
+
+} lmtyn_editor_mesh_worker;
+
+/* Draw lists of the 2D views are executed in square tiles of this many pixels */
+#define LMTYN_EDITOR_TILE_SIZE 64
+/* Commands a draw list holds, a full list is executed and recording continues */
+#define LMTYN_EDITOR_DRAW_COMMANDS 4096
+
+typedef enum lmtyn_editor_draw_command_type
+{
+
+    LMTYN_EDITOR_DRAW_LINE = 0, /* x0, y0 to x1, y1, both inside of the clip rectangle  */
+    LMTYN_EDITOR_DRAW_CIRCLE,   /* center x0, y0, radius x1 and the cross at the center */
+    LMTYN_EDITOR_DRAW_POINT,    /* x0, y0                                               */
+    LMTYN_EDITOR_DRAW_CHARACTER /* top left corner x0, y0, character x1                 */
+
+} lmtyn_editor_draw_command_type;
+
+typedef struct lmtyn_editor_draw_command
+{
+    u32 type;
+    u32 color;
+    i32 x0, y0, x1, y1;
+    i32 clip_x0, clip_y0, clip_x1, clip_y1; /* inclusive, the pixels the command may touch */
+
+} lmtyn_editor_draw_command;
+
+struct lmtyn_editor_draw_list;
+
+typedef struct lmtyn_editor_tile_job
+{
+    struct lmtyn_editor *editor;
+    struct lmtyn_editor_draw_list *list;
+    u32 row;
+
+} lmtyn_editor_tile_job;
+
+/* Commands recorded by a 2D view, see lmtyn_editor_draw_lists_init.
+ * They are binned into the tiles they touch and executed tile by tile in recording order.
+ */
+typedef struct lmtyn_editor_draw_list
+{
+    u8 recording;
+    lmtyn_editor_draw_command *commands;
+    u32 commands_count;
+    u32 commands_done;   /* commands executed by earlier passes over the tiles */
+    u32 commands_binned; /* end of the commands binned for the current pass    */
+
+    u32 *refs; /* command and next reference of the tile for every binned command and tile */
+    u32 refs_capacity;
+    u32 *tiles; /* first and last reference of every tile */
+    lmtyn_editor_tile_job *jobs; /* one per row of tiles */
+
+    i32 x, y;          /* origin of the tiles, the region of the view */
+    u32 tiles_x, tiles_y;
+    i32 clip_x0, clip_y0, clip_x1, clip_y1; /* region of the view inside of the framebuffer */
+
+} lmtyn_editor_draw_list;
+
+/* Glyphs of the built-in font, see [SECTION] Font */
+#define LMTYN_EDITOR_FONT_GLYPH_WIDTH 10
+#define LMTYN_EDITOR_FONT_GLYPH_HEIGHT 22
+#define LMTYN_EDITOR_FONT_GLYPH_COUNT 95
+/* Runs of drawn pixels a row of a glyph has at most */
+#define LMTYN_EDITOR_FONT_SPANS ((LMTYN_EDITOR_FONT_GLYPH_WIDTH + 1) / 2)
+
+/* The glyphs scaled to font_glyph_width x font_glyph_height as runs of pixels, see lmtyn_editor_font_cache_update.
+ * Font row r of a glyph is drawn to the rows [rows[r], rows[r + 1]) below its top left corner.
+ */
+typedef struct lmtyn_editor_font_cache
+{
+    u32 glyph_width; /* size the runs were built for, 0 before the first update */
+    u32 glyph_height;
+    u16 rows[LMTYN_EDITOR_FONT_GLYPH_HEIGHT + 1];
+    u8 spans_count[LMTYN_EDITOR_FONT_GLYPH_COUNT][LMTYN_EDITOR_FONT_GLYPH_HEIGHT];
+    u16 spans[LMTYN_EDITOR_FONT_GLYPH_COUNT][LMTYN_EDITOR_FONT_GLYPH_HEIGHT][LMTYN_EDITOR_FONT_SPANS * 2]; /* first and one past the last column */
+
+} lmtyn_editor_font_cache;
+
+/* No circle, e.g. for circles_hovered_circle_index or the result of lmtyn_editor_circles_nearest */
+#define LMTYN_EDITOR_CIRCLE_NONE 0xFFFFFFFFU
+
 typedef enum lmtyn_editor_selection_mode
 {
 
@@ -111,26 +281,74 @@ typedef struct lmtyn_editor
     u32 grid_color;
     u32 grid_color_axis;
 
+    /* Optional, screen positions of the mesh vertices in the 2D views, see lmtyn_editor_projection_init */
+    i32 *projection;
+    u32 projection_capacity;
+
+    /* Optional, holds the background and grid of the 2D views at their framebuffer positions, see lmtyn_editor_grid_cache_init */
+    u32 *grid_cache;
+    unsigned long grid_cache_size;
+
     lmtyn_editor_selection_mode selection_mode;
     lmtyn_editor_wireframe_mode wireframe_mode;
 
     lmtyn_mesh *mesh;
+    u32 mesh_segments;
     u32 mesh_color_wireframe;
 
+    u8 render_scale_adaptive; /* adjust render_scale to hold render_budget_ms while editing */
+    u8 render_interactive;    /* the user is editing, idle frames render at full resolution */
+    f32 render_scale;         /* 3D view resolution relative to its region while editing    */
+    f32 render_scale_min;     /* 0.25f */
+    f32 render_budget_ms;     /* 8.0f */
+    f32 render_time_ms;       /* measured time of the last 3D view render                   */
+    u8 render_scale_bilinear; /* filter the upscaled 3D view instead of repeating pixels     */
+
     lmtyn_shape_circle *circles;
     u32 circles_capacity;
     u32 circles_count;
     u32 circles_selected_circle_index;
+    u32 circles_hovered_circle_index; /* circle under the mouse in selection mode or LMTYN_EDITOR_CIRCLE_NONE */
+    u8 circles_dragging;              /* the selected circle follows the mouse while the left button is held */
     u32 circles_color;
     u32 circles_color_line;
     u32 circles_color_selected;
+    u32 circles_color_hovered;
     f32 circles_last_x;
     f32 circles_last_y;
     f32 circles_last_z;
     f32 circles_last_radius;
 
+    /* Optional, bounds of runs of consecutive circles for culling, see lmtyn_editor_circle_index_init */
+    f32 *circles_bounds;
+    u32 circles_bounds_blocks; /* bounds of single runs, the bounds of the groups of runs follow them */
+    u32 circles_bounds_count;  /* circles the boxes were computed for */
+
+    /* Optional, uniform grids of the circle centers of the XZ, YZ and XY views for picking */
+    u32 *circles_grid;            /* per view circles_capacity + 1 cell offsets and the circles sorted by cell */
+    u32 circles_grid_cells[3];    /* cells per axis of each view, 0 until the grid is built for the circles */
+    f32 circles_grid_min[3][2];   /* view position of the first cell */
+    f32 circles_grid_scale[3][2]; /* cells per unit */
+
     u32 font_glyph_width;
     u32 font_glyph_height;
+    lmtyn_editor_font_cache font_cache; /* rebuilt by lmtyn_editor_render when the glyph size changed */
+
+    /* Optional, draws the XZ, YZ, XY and 3D views in parallel. Without it they are drawn one after another */
+    lmtyn_editor_jobs_run jobs_run;
+    void *jobs_context;
+
+    /* Optional, generates the mesh off the frame, see lmtyn_editor_mesh_worker_init */
+    lmtyn_editor_mesh_worker *mesh_worker;
+    u32 mesh_generation; /* meshes taken from the worker */
+
+    /* Optional, record the XZ, YZ and XY views and draw them tile by tile, see lmtyn_editor_draw_lists_init */
+    lmtyn_editor_draw_list draw_lists[LMTYN_EDITOR_REGION_RENDER];
+    void **draw_jobs;
+
+    /* Framebuffer areas changed by the last lmtyn_editor_render, the host only has to present these */
+    lmtyn_editor_rect dirty_rects[LMTYN_EDITOR_REGION_COUNT];
+    u32 dirty_rects_count;
 
 } lmtyn_editor;
 
@@ -207,8 +425,6 @@ LMTYN_API LMTYN_INLINE f32 lmtyn_snap(f32 v, f32 interval)
  *
  * Consolas, 10x22 x 95 chars
  */
-#define LMTYN_EDITOR_FONT_GLYPH_WIDTH 10
-#define LMTYN_EDITOR_FONT_GLYPH_HEIGHT 22
 
 static u8 lmtyn_editor_font_data[] = {
     0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0,
@@ -561,6 +777,68 @@ static u8 lmtyn_editor_font_data[] = {
     0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0, 0xFF, 0xC0,
     0xFF, 0xC0, 0xFF, 0xC0};
 
+/* Rebuilds the scaled glyphs if font_glyph_width or font_glyph_height changed since the last update.
+ * Drawn pixel (x, y) of a glyph samples the font at ((x * 10) / font_glyph_width, (y * 22) / font_glyph_height).
+ */
+LMTYN_API void lmtyn_editor_font_cache_update(lmtyn_editor *editor)
+{
+    lmtyn_editor_font_cache *cache = &editor->font_cache;
+    u32 glyph_width = editor->font_glyph_width;
+    u32 glyph_height = editor->font_glyph_height;
+    u32 bytes_per_row = (LMTYN_EDITOR_FONT_GLYPH_WIDTH + 7) / 8;
+    u32 glyph, row, col;
+
+    if (cache->glyph_width == glyph_width && cache->glyph_height == glyph_height)
+    {
+        return;
+    }
+
+    cache->glyph_width = glyph_width;
+    cache->glyph_height = glyph_height;
+
+    /* The first drawn row of font row r is the smallest y with y * 22 >= r * font_glyph_height */
+    for (row = 0; row <= LMTYN_EDITOR_FONT_GLYPH_HEIGHT; ++row)
+    {
+        cache->rows[row] = (u16)((row * glyph_height + LMTYN_EDITOR_FONT_GLYPH_HEIGHT - 1) / LMTYN_EDITOR_FONT_GLYPH_HEIGHT);
+    }
+
+    for (glyph = 0; glyph < LMTYN_EDITOR_FONT_GLYPH_COUNT; ++glyph)
+    {
+        for (row = 0; row < LMTYN_EDITOR_FONT_GLYPH_HEIGHT; ++row)
+        {
+            u8 *bits = &lmtyn_editor_font_data[(glyph * LMTYN_EDITOR_FONT_GLYPH_HEIGHT + row) * bytes_per_row];
+            u16 *spans = cache->spans[glyph][row];
+            u32 spans_count = 0;
+
+            for (col = 0; col < LMTYN_EDITOR_FONT_GLYPH_WIDTH; ++col)
+            {
+                /* Drawn columns of font column col, same rounding as the rows */
+                u16 start = (u16)((col * glyph_width + LMTYN_EDITOR_FONT_GLYPH_WIDTH - 1) / LMTYN_EDITOR_FONT_GLYPH_WIDTH);
+                u16 end = (u16)(((col + 1) * glyph_width + LMTYN_EDITOR_FONT_GLYPH_WIDTH - 1) / LMTYN_EDITOR_FONT_GLYPH_WIDTH);
+
+                /* A cleared bit is a drawn pixel */
+                if ((bits[col / 8] & (u8)(1 << (7 - (col % 8)))) || start == end)
+                {
+                    continue;
+                }
+
+                if (spans_count && spans[spans_count * 2 - 1] == start)
+                {
+                    spans[spans_count * 2 - 1] = end;
+                }
+                else
+                {
+                    spans[spans_count * 2] = start;
+                    spans[spans_count * 2 + 1] = end;
+                    spans_count++;
+                }
+            }
+
+            cache->spans_count[glyph][row] = (u8)spans_count;
+        }
+    }
+}
+
 LMTYN_API LMTYN_INLINE u8 lmtyn_editor_is_drawing_region(lmtyn_editor *editor)
 {
     return editor->regions_selected_region_index >= 0 &&
@@ -569,21 +847,18 @@ LMTYN_API LMTYN_INLINE u8 lmtyn_editor_is_drawing_region(lmtyn_editor *editor)
             editor->regions_selected_region_index == LMTYN_EDITOR_REGION_XY);
 }
 
-LMTYN_API void lmtyn_editor_draw_character(
+/* Draws the part of a character inside the inclusive rectangle [min_x, max_x] x [min_y, max_y].
+ * Uses the font cache, see lmtyn_editor_font_cache_update.
+ */
+LMTYN_API void lmtyn_editor_raster_character(
     lmtyn_editor *editor,
-    u32 x, u32 y, u8 c, u32 color_fg)
+    i32 x, i32 y, u8 c, u32 color_fg,
+    i32 min_x, i32 min_y, i32 max_x, i32 max_y)
 {
-    u32 row, col;
+    lmtyn_editor_font_cache *cache = &editor->font_cache;
     u32 fb_w = editor->framebuffer_width;
-    u32 fb_h = editor->framebuffer_height;
-    u32 start_col = 0, end_col = editor->font_glyph_width;
-    u32 start_row = 0, end_row = editor->font_glyph_height;
-    u32 *dst_ptr_base;
-
-    u32 base_bytes_per_row = (LMTYN_EDITOR_FONT_GLYPH_WIDTH + 7) / 8;
-    u32 base_glyph_size = base_bytes_per_row * LMTYN_EDITOR_FONT_GLYPH_HEIGHT;
-    u32 glyph_index;
-    u8 *glyph;
+    u8 *spans_count;
+    u32 row, span;
 
     if (c < 32 || c > 126)
     {
@@ -591,46 +866,99 @@ LMTYN_API void lmtyn_editor_draw_character(
     }
 
     /* Pre-Clip Bounds */
-    if (x >= fb_w || y >= fb_h)
+    if (x > max_x || y > max_y || x + (i32)cache->glyph_width <= min_x || y + (i32)cache->glyph_height <= min_y)
     {
         return;
     }
 
-    if (x + end_col > fb_w)
+    spans_count = cache->spans_count[c - 32];
+
+    for (row = 0; row < LMTYN_EDITOR_FONT_GLYPH_HEIGHT; ++row)
     {
-        end_col = fb_w - x;
+        u16 *spans = cache->spans[c - 32][row];
+        i32 y0 = y + (i32)cache->rows[row];
+        i32 y1 = y + (i32)cache->rows[row + 1];
+
+        y0 = y0 < min_y ? min_y : y0;
+        y1 = y1 > max_y + 1 ? max_y + 1 : y1;
+
+        for (span = 0; y0 < y1 && span < spans_count[row]; ++span)
+        {
+            i32 x0 = x + (i32)spans[span * 2];
+            i32 x1 = x + (i32)spans[span * 2 + 1];
+            i32 py, px;
+
+            x0 = x0 < min_x ? min_x : x0;
+            x1 = x1 > max_x + 1 ? max_x + 1 : x1;
+
+            for (py = y0; py < y1; ++py)
+            {
+                u32 *dst = editor->framebuffer + (u32)py * fb_w;
+
+                for (px = x0; px < x1; ++px)
+                {
+                    dst[px] = color_fg;
+                }
+            }
+        }
     }
+}
+
+/* Draws a character that lies completely inside of the framebuffer, dst is its top left corner */
+LMTYN_API void lmtyn_editor_blit_character(
+    lmtyn_editor *editor,
+    u32 *dst, u8 c, u32 color_fg)
+{
+    lmtyn_editor_font_cache *cache = &editor->font_cache;
+    u32 fb_w = editor->framebuffer_width;
+    u8 *spans_count;
+    u32 row, span;
 
-    if (y + end_row > fb_h)
+    if (c < 32 || c > 126)
     {
-        end_row = fb_h - y;
+        return;
     }
 
-    glyph_index = (c - 32) * base_glyph_size;
-    glyph = &lmtyn_editor_font_data[glyph_index];
+    spans_count = cache->spans_count[c - 32];
 
-    /* Calculate base pointer to framebuffer */
-    dst_ptr_base = editor->framebuffer + (y * fb_w) + x;
-
-    for (row = start_row; row < end_row; ++row)
+    for (row = 0; row < LMTYN_EDITOR_FONT_GLYPH_HEIGHT; ++row)
     {
-        u32 sample_row = (row * LMTYN_EDITOR_FONT_GLYPH_HEIGHT) / editor->font_glyph_height;
-        u32 row_offset = sample_row * base_bytes_per_row;
+        u16 *spans = cache->spans[c - 32][row];
+        u32 *dst_row = dst + cache->rows[row] * fb_w;
+        u32 rows_count = (u32)(cache->rows[row + 1] - cache->rows[row]);
 
-        for (col = start_col; col < end_col; ++col)
+        for (span = 0; span < spans_count[row]; ++span)
         {
-            u32 sample_col = (col * LMTYN_EDITOR_FONT_GLYPH_WIDTH) / editor->font_glyph_width;
-            u32 bit_mask = (u8)(1 << (7 - (sample_col % 8)));
+            u32 *dst_span = dst_row + spans[span * 2];
+            u32 width = (u32)(spans[span * 2 + 1] - spans[span * 2]);
+            u32 py, px;
 
-            if (!(glyph[row_offset + (sample_col / 8)] & bit_mask))
+            for (py = 0; py < rows_count; ++py)
             {
-                dst_ptr_base[col] = color_fg;
+                for (px = 0; px < width; ++px)
+                {
+                    dst_span[px] = color_fg;
+                }
+                dst_span += fb_w;
             }
         }
-        dst_ptr_base += fb_w;
     }
 }
 
+LMTYN_API void lmtyn_editor_draw_character(
+    lmtyn_editor *editor,
+    u32 x, u32 y, u8 c, u32 color_fg)
+{
+    if (x >= editor->framebuffer_width || y >= editor->framebuffer_height)
+    {
+        return;
+    }
+
+    lmtyn_editor_raster_character(
+        editor, (i32)x, (i32)y, c, color_fg,
+        0, 0, (i32)editor->framebuffer_width - 1, (i32)editor->framebuffer_height - 1);
+}
+
 LMTYN_API void lmtyn_editor_draw_text(
     lmtyn_editor *editor,
     u32 x,
@@ -640,22 +968,43 @@ LMTYN_API void lmtyn_editor_draw_text(
 {
     u32 cursor_x = x;
     u32 cursor_y = y;
-    u32 i = 0;
+    u32 length = 0;
+    u32 i;
 
     if (!text)
         return;
 
-    while (text[i] != '\0')
+    /* Hosts may draw text outside of lmtyn_editor_render */
+    lmtyn_editor_font_cache_update(editor);
+
+    while (text[length] != '\0')
     {
-        char c = text[i];
+        length++;
+    }
+
+    /* One clip test for the whole string, only strings crossing the framebuffer border are clipped per character */
+    if (x <= editor->framebuffer_width && y <= editor->framebuffer_height &&
+        length <= (editor->framebuffer_width - x) / (editor->font_glyph_width ? editor->font_glyph_width : 1) &&
+        editor->font_glyph_height <= editor->framebuffer_height - y)
+    {
+        u32 *dst = editor->framebuffer + y * editor->framebuffer_width + x;
+
+        for (i = 0; i < length; ++i)
+        {
+            lmtyn_editor_blit_character(editor, dst, (u8)text[i], color_fg);
+            dst += editor->font_glyph_width;
+        }
+
+        return;
+    }
 
+    for (i = 0; i < length; ++i)
+    {
         /* Draw the character */
-        lmtyn_editor_draw_character(editor, cursor_x, cursor_y, (u8)c, color_fg);
+        lmtyn_editor_draw_character(editor, cursor_x, cursor_y, (u8)text[i], color_fg);
 
         /* Advance cursor horizontally */
         cursor_x += editor->font_glyph_width;
-
-        i++;
     }
 }
 
@@ -880,86 +1229,220 @@ LMTYN_API void lmtyn_editor_world_to_screen(
     *sy = r->y + (u32)(ny * r->h);
 }
 
-LMTYN_API void lmtyn_editor_draw_line(
+/* Same as lmtyn_editor_world_to_screen without the truncation to pixels, points outside of the region stay valid */
+LMTYN_API void lmtyn_editor_world_to_screen_f32(
     lmtyn_editor *editor,
     u32 region_index,
-    i32 x0,
-    i32 y0,
-    i32 x1,
-    i32 y1,
-    u32 color)
+    f32 wx, f32 wy, f32 *sx, f32 *sy)
 {
     lmtyn_editor_region *r = &editor->regions[region_index];
-    i32 fb_w = (i32)editor->framebuffer_width;
-    i32 fb_h = (i32)editor->framebuffer_height;
 
-    i32 dx = lmtyn_absi(x1 - x0);
-    i32 sx = x0 < x1 ? 1 : -1;
-    i32 dy = -lmtyn_absi(y1 - y0);
-    i32 sy = y0 < y1 ? 1 : -1;
-    i32 err = dx + dy;
+    f32 nx = (wx - r->grid_scroll_offset_x) / editor->grid_scale;
+    f32 ny = (wy - r->grid_scroll_offset_y) / editor->grid_scale;
+
+    if (region_index == LMTYN_EDITOR_REGION_XY)
+    {
+        ny = -ny;
+    }
+
+    nx = (nx * 0.5f) + 0.5f;
+    ny = (ny * 0.5f) + 0.5f;
+
+    *sx = (f32)r->x + nx * (f32)r->w;
+    *sy = (f32)r->y + ny * (f32)r->h;
+}
 
-    i32 x = x0;
-    i32 y = y0;
+/* Same as lmtyn_editor_screen_to_world for positions between or outside of the pixels */
+LMTYN_API void lmtyn_editor_screen_to_world_f32(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 sx, f32 sy, f32 *wx, f32 *wy)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
 
-    i32 max_steps = fb_w + fb_h;
-    i32 steps = 0;
+    f32 nx = ((sx - (f32)r->x) / (f32)r->w - 0.5f) * 2.0f;
+    f32 ny = ((sy - (f32)r->y) / (f32)r->h - 0.5f) * 2.0f;
 
-    while (1)
+    if (region_index == LMTYN_EDITOR_REGION_XY)
     {
-        i32 e2;
+        ny = -ny;
+    }
 
-        if (++steps > max_steps)
-        {
-            break;
-        }
+    *wx = nx * editor->grid_scale + r->grid_scroll_offset_x;
+    *wy = ny * editor->grid_scale + r->grid_scroll_offset_y;
+}
 
-        if (x >= (i32)r->x && x < (i32)(r->x + r->w) &&
-            y >= (i32)r->y && y < (i32)(r->y + r->h) &&
-            x >= 0 && x < fb_w && y >= 0 && y < fb_h)
-        {
-            editor->framebuffer[y * fb_w + x] = color;
-        }
+/* Clips the segment to the rectangle [min_x, max_x] x [min_y, max_y] (Liang-Barsky).
+ * Returns 0 if nothing is visible, otherwise the visible part is t0 <= t <= t1.
+ */
+LMTYN_API LMTYN_INLINE u8 lmtyn_editor_clip_segment(
+    f32 x0, f32 y0, f32 x1, f32 y1,
+    f32 min_x, f32 min_y, f32 max_x, f32 max_y,
+    f32 *t0, f32 *t1)
+{
+    f32 p[4];
+    f32 q[4];
+    u32 i;
 
-        if (x == x1 && y == y1)
-        {
-            break;
-        }
+    p[0] = x0 - x1;
+    p[1] = x1 - x0;
+    p[2] = y0 - y1;
+    p[3] = y1 - y0;
+
+    q[0] = x0 - min_x;
+    q[1] = max_x - x0;
+    q[2] = y0 - min_y;
+    q[3] = max_y - y0;
 
-        e2 = 2 * err;
+    *t0 = 0.0f;
+    *t1 = 1.0f;
 
-        if (e2 >= dy)
+    for (i = 0; i < 4; ++i)
+    {
+        if (p[i] == 0.0f)
         {
-            err += dy;
-            x += sx;
+            /* Parallel to this edge and outside of it */
+            if (q[i] < 0.0f)
+            {
+                return 0;
+            }
         }
-
-        if (e2 <= dx)
+        else
         {
-            err += dx;
-            y += sy;
+            f32 t = q[i] / p[i];
+
+            if (p[i] < 0.0f)
+            {
+                *t0 = t > *t0 ? t : *t0;
+            }
+            else
+            {
+                *t1 = t < *t1 ? t : *t1;
+            }
         }
     }
+
+    return *t0 <= *t1;
 }
 
-LMTYN_API void lmtyn_editor_draw_circle(
+/* Walks the Bresenham (midpoint) line from x0, y0 to x1, y1 but only writes its pixels inside of the
+ * inclusive rectangle [min_x, max_x] x [min_y, max_y]. The first and last step inside of the rectangle
+ * are computed directly, so every tile of a line draws the pixels of the same single walk and the inner
+ * loop needs no bounds tests.
+ */
+LMTYN_API void lmtyn_editor_raster_line(
     lmtyn_editor *editor,
-    u32 region_index,
-    i32 cx,
-    i32 cy,
-    i32 radius,
+    i32 x0, i32 y0, i32 x1, i32 y1,
+    i32 min_x, i32 min_y, i32 max_x, i32 max_y,
     u32 color)
 {
-    lmtyn_editor_region *r = &editor->regions[region_index];
+    i32 fb_w = (i32)editor->framebuffer_width;
+    i32 dx = lmtyn_absi(x1 - x0);
+    i32 dy = lmtyn_absi(y1 - y0);
+    i32 step_x = x0 < x1 ? 1 : -1;
+    i32 step_y = y0 < y1 ? 1 : -1;
 
-    u32 fb_w = editor->framebuffer_width;
-    u32 fb_h = editor->framebuffer_height;
+    /* Range of the rectangle in steps along each axis, relative to the start point */
+    i32 range_x0 = step_x > 0 ? min_x - x0 : x0 - max_x;
+    i32 range_x1 = step_x > 0 ? max_x - x0 : x0 - min_x;
+    i32 range_y0 = step_y > 0 ? min_y - y0 : y0 - max_y;
+    i32 range_y1 = step_y > 0 ? max_y - y0 : y0 - min_y;
+
+    i32 major, minor, major_step, minor_step;
+    i32 major_lo, major_hi, minor_lo, minor_hi;
+    i32 first, last, k, err, index, i;
+
+    if (dx >= dy)
+    {
+        major = dx;
+        minor = dy;
+        major_step = step_x;
+        minor_step = step_y * fb_w;
+        major_lo = range_x0;
+        major_hi = range_x1;
+        minor_lo = range_y0;
+        minor_hi = range_y1;
+    }
+    else
+    {
+        major = dy;
+        minor = dx;
+        major_step = step_y * fb_w;
+        minor_step = step_x;
+        major_lo = range_y0;
+        major_hi = range_y1;
+        minor_lo = range_x0;
+        minor_hi = range_x1;
+    }
+
+    first = major_lo > 0 ? major_lo : 0;
+    last = major_hi < major ? major_hi : major;
+
+    if (minor_hi < 0 || minor_lo > minor)
+    {
+        return;
+    }
+
+    /* After i steps the walk took k(i) = (2 * minor * i + major - 1) / (2 * major) minor steps,
+     * the steps whose k(i) lies in [minor_lo, minor_hi] follow from solving for i
+     */
+    if (minor_lo > 0)
+    {
+        i32 t = (2 * major * minor_lo - major + 2 * minor) / (2 * minor);
+        first = t > first ? t : first;
+    }
+
+    if (minor_hi < minor)
+    {
+        i32 t = (2 * major * (minor_hi + 1) - major + 2 * minor) / (2 * minor) - 1;
+        last = t < last ? t : last;
+    }
+
+    if (first > last)
+    {
+        return;
+    }
+
+    k = first > 0 ? (2 * minor * first + major - 1) / (2 * major) : 0;
+    err = 2 * minor * (first + 1) - major - 2 * major * k;
+    index = y0 * fb_w + x0 + first * major_step + k * minor_step;
+
+    for (i = first; i <= last; ++i)
+    {
+        /* All bits set if the minor axis steps as well */
+        i32 mask = -(err > 0);
+
+        editor->framebuffer[index] = color;
+
+        index += major_step + (minor_step & mask);
+        err += 2 * minor - ((2 * major) & mask);
+    }
+}
+
+/* Draws the outline and center cross of a circle inside of the inclusive rectangle [min_x, max_x] x [min_y, max_y] */
+LMTYN_API void lmtyn_editor_raster_circle(
+    lmtyn_editor *editor,
+    i32 cx, i32 cy, i32 radius,
+    i32 min_x, i32 min_y, i32 max_x, i32 max_y,
+    u32 color)
+{
+    u32 *pixels = editor->framebuffer;
+    i32 fb_w = (i32)editor->framebuffer_width;
 
     i32 x = radius;
     i32 y = 0;
     i32 err = 1 - x;
 
     i32 cross_size = 6;
+    i32 extent = radius > cross_size ? radius : cross_size;
+
+    /* Circles completely inside need no tests per pixel */
+    u8 inside = cx - extent >= min_x && cx + extent <= max_x && cy - extent >= min_y && cy + extent <= max_y;
+
+    if (cx + extent < min_x || cx - extent > max_x || cy + extent < min_y || cy - extent > max_y)
+    {
+        return;
+    }
 
     while (x >= y)
     {
@@ -988,12 +1471,9 @@ LMTYN_API void lmtyn_editor_draw_circle(
             i32 px = pts[i][0];
             i32 py = pts[i][1];
 
-            if (px >= (i32)r->x && px < (i32)(r->x + r->w) &&
-                py >= (i32)r->y && py < (i32)(r->y + r->h) &&
-                px >= 0 && px < fb_w &&
-                py >= 0 && py < fb_h)
+            if (inside || (px >= min_x && px <= max_x && py >= min_y && py <= max_y))
             {
-                editor->framebuffer[py * editor->framebuffer_width + px] = color;
+                pixels[py * fb_w + px] = color;
             }
         }
 
@@ -1010,43 +1490,526 @@ LMTYN_API void lmtyn_editor_draw_circle(
         }
     }
 
-    /* --- Draw cross in the center --- */
+    /* --- Draw cross in the center, clipped as spans --- */
+    if (cy >= min_y && cy <= max_y)
     {
-        i32 dx, dy;
+        i32 x0 = cx - cross_size > min_x ? cx - cross_size : min_x;
+        i32 x1 = cx + cross_size < max_x ? cx + cross_size : max_x;
 
-        for (dx = -cross_size; dx <= cross_size; ++dx)
+        for (x = x0; x <= x1; ++x)
         {
-            i32 px = cx + dx;
-            i32 py = cy;
-
-            if (px >= (i32)r->x && px < (i32)(r->x + r->w) &&
-                py >= (i32)r->y && py < (i32)(r->y + r->h) &&
-                px >= 0 && px < (i32)fb_w &&
-                py >= 0 && py < (i32)fb_h)
-            {
-                editor->framebuffer[py * editor->framebuffer_width + px] = color;
-            }
+            pixels[cy * fb_w + x] = color;
         }
+    }
 
-        for (dy = -cross_size; dy <= cross_size; ++dy)
+    if (cx >= min_x && cx <= max_x)
+    {
+        i32 y0 = cy - cross_size > min_y ? cy - cross_size : min_y;
+        i32 y1 = cy + cross_size < max_y ? cy + cross_size : max_y;
+
+        for (y = y0; y <= y1; ++y)
+        {
+            pixels[y * fb_w + cx] = color;
+        }
+    }
+}
+
+/* #############################################################################
+ * # [SECTION] Draw Lists
+ * #############################################################################
+ *
+ * The XZ, YZ and XY views can record their lines, circles, points and characters instead of drawing
+ * them right away. A recorded list is binned into LMTYN_EDITOR_TILE_SIZE tiles and executed tile by
+ * tile, every tile stays in the cache while all of its commands are drawn and the primitives are only
+ * clipped once per tile. The rows of tiles of all views are executed in parallel through jobs_run.
+ */
+#define LMTYN_EDITOR_DRAW_REF_NONE 0xFFFFFFFFU
+
+/* Tiles covering a framebuffer, the region of any view fits into them */
+LMTYN_API u32 lmtyn_editor_draw_list_tiles(u32 framebuffer_width, u32 framebuffer_height, u32 *tiles_y)
+{
+    *tiles_y = (framebuffer_height + LMTYN_EDITOR_TILE_SIZE - 1) / LMTYN_EDITOR_TILE_SIZE;
+
+    return ((framebuffer_width + LMTYN_EDITOR_TILE_SIZE - 1) / LMTYN_EDITOR_TILE_SIZE) * *tiles_y;
+}
+
+/* Memory needed by lmtyn_editor_draw_lists_init for the draw lists of the three 2D views */
+LMTYN_API unsigned long lmtyn_editor_draw_lists_size(u32 framebuffer_width, u32 framebuffer_height)
+{
+    u32 tiles_y;
+    u32 tiles = lmtyn_editor_draw_list_tiles(framebuffer_width, framebuffer_height, &tiles_y);
+    unsigned long list_size = 0;
+
+    list_size += (unsigned long)tiles_y * (sizeof(void *) + sizeof(lmtyn_editor_tile_job));
+    list_size += (unsigned long)LMTYN_EDITOR_DRAW_COMMANDS * sizeof(lmtyn_editor_draw_command);
+    list_size += (unsigned long)(4 * LMTYN_EDITOR_DRAW_COMMANDS + tiles) * 2 * sizeof(u32);
+    list_size += (unsigned long)tiles * 2 * sizeof(u32);
+
+    return LMTYN_EDITOR_REGION_RENDER * list_size;
+}
+
+/* Attaches the draw lists, has to be called again after the framebuffer was resized.
+ * Returns 0 if the memory is too small, the views draw immediately then.
+ */
+LMTYN_API u8 lmtyn_editor_draw_lists_init(lmtyn_editor *editor, void *memory, unsigned long memory_size)
+{
+    u32 tiles_y;
+    u32 tiles = lmtyn_editor_draw_list_tiles(editor->framebuffer_width, editor->framebuffer_height, &tiles_y);
+    u8 *data = (u8 *)memory;
+    u32 i;
+
+    for (i = 0; i < LMTYN_EDITOR_REGION_RENDER; ++i)
+    {
+        lmtyn_editor_draw_list *list = &editor->draw_lists[i];
+
+        list->recording = 0;
+        list->commands = 0;
+        list->commands_count = 0;
+        list->commands_done = 0;
+        list->commands_binned = 0;
+        list->refs = 0;
+        list->refs_capacity = 0;
+        list->tiles = 0;
+        list->jobs = 0;
+        list->x = 0;
+        list->y = 0;
+        list->tiles_x = 0;
+        list->tiles_y = 0;
+        list->clip_x0 = list->clip_y0 = 0;
+        list->clip_x1 = list->clip_y1 = -1;
+    }
+
+    editor->draw_jobs = 0;
+
+    if (!memory || memory_size < lmtyn_editor_draw_lists_size(editor->framebuffer_width, editor->framebuffer_height))
+    {
+        return 0;
+    }
+
+    /* Pointers first, the remaining arrays only need 4 byte alignment */
+    editor->draw_jobs = (void **)data;
+    data += LMTYN_EDITOR_REGION_RENDER * tiles_y * sizeof(void *);
+
+    for (i = 0; i < LMTYN_EDITOR_REGION_RENDER; ++i)
+    {
+        lmtyn_editor_draw_list *list = &editor->draw_lists[i];
+
+        list->jobs = (lmtyn_editor_tile_job *)data;
+        data += tiles_y * sizeof(lmtyn_editor_tile_job);
+    }
+
+    for (i = 0; i < LMTYN_EDITOR_REGION_RENDER; ++i)
+    {
+        lmtyn_editor_draw_list *list = &editor->draw_lists[i];
+
+        list->commands = (lmtyn_editor_draw_command *)data;
+        data += LMTYN_EDITOR_DRAW_COMMANDS * sizeof(lmtyn_editor_draw_command);
+        list->refs_capacity = 4 * LMTYN_EDITOR_DRAW_COMMANDS + tiles;
+        list->refs = (u32 *)data;
+        data += list->refs_capacity * 2 * sizeof(u32);
+        list->tiles = (u32 *)data;
+        data += tiles * 2 * sizeof(u32);
+    }
+
+    return 1;
+}
+
+/* Starts recording the commands of a 2D view, does nothing without draw lists */
+LMTYN_API void lmtyn_editor_draw_list_begin(lmtyn_editor *editor, u32 region_index)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    lmtyn_editor_draw_list *list = &editor->draw_lists[region_index];
+
+    if (!list->commands || r->w == 0 || r->h == 0)
+    {
+        return;
+    }
+
+    list->recording = 1;
+    list->commands_count = 0;
+    list->commands_done = 0;
+    list->commands_binned = 0;
+    list->x = (i32)r->x;
+    list->y = (i32)r->y;
+    list->tiles_x = (r->w + LMTYN_EDITOR_TILE_SIZE - 1) / LMTYN_EDITOR_TILE_SIZE;
+    list->tiles_y = (r->h + LMTYN_EDITOR_TILE_SIZE - 1) / LMTYN_EDITOR_TILE_SIZE;
+    list->clip_x0 = (i32)r->x;
+    list->clip_y0 = (i32)r->y;
+    list->clip_x1 = (i32)(r->x + r->w < editor->framebuffer_width ? r->x + r->w : editor->framebuffer_width) - 1;
+    list->clip_y1 = (i32)(r->y + r->h < editor->framebuffer_height ? r->y + r->h : editor->framebuffer_height) - 1;
+}
+
+/* Pixels a command can touch, returns 0 if there are none */
+LMTYN_API u8 lmtyn_editor_draw_command_bounds(
+    lmtyn_editor *editor,
+    lmtyn_editor_draw_command *command,
+    i32 *x0, i32 *y0, i32 *x1, i32 *y1)
+{
+    i32 extent;
+
+    switch (command->type)
+    {
+    case LMTYN_EDITOR_DRAW_LINE:
+        *x0 = command->x0 < command->x1 ? command->x0 : command->x1;
+        *x1 = command->x0 < command->x1 ? command->x1 : command->x0;
+        *y0 = command->y0 < command->y1 ? command->y0 : command->y1;
+        *y1 = command->y0 < command->y1 ? command->y1 : command->y0;
+        break;
+    case LMTYN_EDITOR_DRAW_CIRCLE:
+        extent = command->x1 > 6 ? command->x1 : 6;
+        *x0 = command->x0 - extent;
+        *x1 = command->x0 + extent;
+        *y0 = command->y0 - extent;
+        *y1 = command->y0 + extent;
+        break;
+    case LMTYN_EDITOR_DRAW_CHARACTER:
+        *x0 = command->x0;
+        *y0 = command->y0;
+        *x1 = command->x0 + (i32)editor->font_glyph_width - 1;
+        *y1 = command->y0 + (i32)editor->font_glyph_height - 1;
+        break;
+    default:
+        *x0 = *x1 = command->x0;
+        *y0 = *y1 = command->y0;
+        break;
+    }
+
+    *x0 = *x0 > command->clip_x0 ? *x0 : command->clip_x0;
+    *y0 = *y0 > command->clip_y0 ? *y0 : command->clip_y0;
+    *x1 = *x1 < command->clip_x1 ? *x1 : command->clip_x1;
+    *y1 = *y1 < command->clip_y1 ? *y1 : command->clip_y1;
+
+    return *x0 <= *x1 && *y0 <= *y1;
+}
+
+/* Bins the commands following commands_done into the tiles they touch until the references run out,
+ * the pass covers the commands up to commands_binned
+ */
+LMTYN_API void lmtyn_editor_draw_list_bin(lmtyn_editor *editor, lmtyn_editor_draw_list *list)
+{
+    u32 tiles = list->tiles_x * list->tiles_y;
+    u32 refs_count = 0;
+    u32 c, t;
+
+    for (t = 0; t < tiles; ++t)
+    {
+        list->tiles[t * 2] = LMTYN_EDITOR_DRAW_REF_NONE;
+        list->tiles[t * 2 + 1] = LMTYN_EDITOR_DRAW_REF_NONE;
+    }
+
+    for (c = list->commands_done; c < list->commands_count; ++c)
+    {
+        i32 x0, y0, x1, y1;
+        u32 tx0, ty0, tx1, ty1, tx, ty;
+
+        if (!lmtyn_editor_draw_command_bounds(editor, &list->commands[c], &x0, &y0, &x1, &y1))
+        {
+            continue;
+        }
+
+        tx0 = (u32)(x0 - list->x) / LMTYN_EDITOR_TILE_SIZE;
+        ty0 = (u32)(y0 - list->y) / LMTYN_EDITOR_TILE_SIZE;
+        tx1 = (u32)(x1 - list->x) / LMTYN_EDITOR_TILE_SIZE;
+        ty1 = (u32)(y1 - list->y) / LMTYN_EDITOR_TILE_SIZE;
+
+        /* The rest goes into the next pass */
+        if (refs_count + (tx1 - tx0 + 1) * (ty1 - ty0 + 1) > list->refs_capacity)
+        {
+            break;
+        }
+
+        for (ty = ty0; ty <= ty1; ++ty)
+        {
+            for (tx = tx0; tx <= tx1; ++tx)
+            {
+                u32 *tile = &list->tiles[(ty * list->tiles_x + tx) * 2];
+
+                list->refs[refs_count * 2] = c;
+                list->refs[refs_count * 2 + 1] = LMTYN_EDITOR_DRAW_REF_NONE;
+
+                if (tile[0] == LMTYN_EDITOR_DRAW_REF_NONE)
+                {
+                    tile[0] = refs_count;
+                }
+                else
+                {
+                    list->refs[tile[1] * 2 + 1] = refs_count;
+                }
+
+                tile[1] = refs_count++;
+            }
+        }
+    }
+
+    list->commands_binned = c;
+}
+
+/* Executes the binned commands of one row of tiles */
+LMTYN_API void lmtyn_editor_draw_list_execute_row(lmtyn_editor *editor, lmtyn_editor_draw_list *list, u32 row)
+{
+    u32 tx;
+
+    for (tx = 0; tx < list->tiles_x; ++tx)
+    {
+        i32 tile_x0 = list->x + (i32)(tx * LMTYN_EDITOR_TILE_SIZE);
+        i32 tile_y0 = list->y + (i32)(row * LMTYN_EDITOR_TILE_SIZE);
+        i32 tile_x1 = tile_x0 + LMTYN_EDITOR_TILE_SIZE - 1;
+        i32 tile_y1 = tile_y0 + LMTYN_EDITOR_TILE_SIZE - 1;
+        u32 ref = list->tiles[(row * list->tiles_x + tx) * 2];
+
+        for (; ref != LMTYN_EDITOR_DRAW_REF_NONE; ref = list->refs[ref * 2 + 1])
+        {
+            lmtyn_editor_draw_command *command = &list->commands[list->refs[ref * 2]];
+
+            i32 x0 = tile_x0 > command->clip_x0 ? tile_x0 : command->clip_x0;
+            i32 y0 = tile_y0 > command->clip_y0 ? tile_y0 : command->clip_y0;
+            i32 x1 = tile_x1 < command->clip_x1 ? tile_x1 : command->clip_x1;
+            i32 y1 = tile_y1 < command->clip_y1 ? tile_y1 : command->clip_y1;
+
+            switch (command->type)
+            {
+            case LMTYN_EDITOR_DRAW_LINE:
+                lmtyn_editor_raster_line(editor, command->x0, command->y0, command->x1, command->y1, x0, y0, x1, y1, command->color);
+                break;
+            case LMTYN_EDITOR_DRAW_CIRCLE:
+                lmtyn_editor_raster_circle(editor, command->x0, command->y0, command->x1, x0, y0, x1, y1, command->color);
+                break;
+            case LMTYN_EDITOR_DRAW_CHARACTER:
+                lmtyn_editor_raster_character(editor, command->x0, command->y0, (u8)command->x1, command->color, x0, y0, x1, y1);
+                break;
+            default:
+                editor->framebuffer[command->y0 * (i32)editor->framebuffer_width + command->x0] = command->color;
+                break;
+            }
+        }
+    }
+}
+
+LMTYN_API void lmtyn_editor_draw_list_tile_job(void *job_data)
+{
+    lmtyn_editor_tile_job *job = (lmtyn_editor_tile_job *)job_data;
+    lmtyn_editor_draw_list_execute_row(job->editor, job->list, job->row);
+}
+
+/* Executes all recorded commands of a view on the calling thread */
+LMTYN_API void lmtyn_editor_draw_list_flush(lmtyn_editor *editor, lmtyn_editor_draw_list *list)
+{
+    u32 row;
+
+    while (list->commands_done < list->commands_count)
+    {
+        lmtyn_editor_draw_list_bin(editor, list);
+
+        for (row = 0; row < list->tiles_y; ++row)
+        {
+            lmtyn_editor_draw_list_execute_row(editor, list, row);
+        }
+
+        list->commands_done = list->commands_binned;
+    }
+
+    list->commands_count = 0;
+    list->commands_done = 0;
+}
+
+/* Executes the recorded commands of all views and stops recording, the rows of tiles run in parallel
+ * through jobs_run
+ */
+LMTYN_API void lmtyn_editor_draw_lists_execute(lmtyn_editor *editor)
+{
+    u32 i, row;
+
+    for (;;)
+    {
+        u32 jobs_count = 0;
+
+        for (i = 0; i < LMTYN_EDITOR_REGION_RENDER; ++i)
         {
-            i32 px = cx;
-            i32 py = cy + dy;
+            lmtyn_editor_draw_list *list = &editor->draw_lists[i];
 
-            if (px >= (i32)r->x && px < (i32)(r->x + r->w) &&
-                py >= (i32)r->y && py < (i32)(r->y + r->h) &&
-                px >= 0 && px < (i32)fb_w &&
-                py >= 0 && py < (i32)fb_h)
+            if (!list->recording || list->commands_done >= list->commands_count)
             {
-                editor->framebuffer[py * editor->framebuffer_width + px] = color;
+                continue;
             }
+
+            lmtyn_editor_draw_list_bin(editor, list);
+
+            for (row = 0; row < list->tiles_y; ++row)
+            {
+                list->jobs[row].editor = editor;
+                list->jobs[row].list = list;
+                list->jobs[row].row = row;
+                editor->draw_jobs[jobs_count++] = &list->jobs[row];
+            }
+        }
+
+        if (jobs_count == 0)
+        {
+            break;
         }
+
+        if (editor->jobs_run && jobs_count > 1)
+        {
+            editor->jobs_run(editor->jobs_context, lmtyn_editor_draw_list_tile_job, editor->draw_jobs, jobs_count);
+        }
+        else
+        {
+            for (i = 0; i < jobs_count; ++i)
+            {
+                lmtyn_editor_draw_list_tile_job(editor->draw_jobs[i]);
+            }
+        }
+
+        for (i = 0; i < LMTYN_EDITOR_REGION_RENDER; ++i)
+        {
+            lmtyn_editor_draw_list *list = &editor->draw_lists[i];
+
+            if (list->recording)
+            {
+                list->commands_done = list->commands_binned;
+            }
+        }
+    }
+
+    for (i = 0; i < LMTYN_EDITOR_REGION_RENDER; ++i)
+    {
+        editor->draw_lists[i].recording = 0;
+        editor->draw_lists[i].commands_count = 0;
+        editor->draw_lists[i].commands_done = 0;
+    }
+}
+
+/* Next command of a recording view clipped to its region, 0 if the view draws immediately */
+LMTYN_API lmtyn_editor_draw_command *lmtyn_editor_draw_list_push(lmtyn_editor *editor, u32 region_index, u32 type, u32 color)
+{
+    lmtyn_editor_draw_list *list;
+    lmtyn_editor_draw_command *command;
+
+    if (region_index >= LMTYN_EDITOR_REGION_RENDER || !editor->draw_lists[region_index].recording)
+    {
+        return 0;
+    }
+
+    list = &editor->draw_lists[region_index];
+
+    /* A full list is drawn by this view and recording starts over */
+    if (list->commands_count == LMTYN_EDITOR_DRAW_COMMANDS)
+    {
+        lmtyn_editor_draw_list_flush(editor, list);
+    }
+
+    command = &list->commands[list->commands_count++];
+    command->type = type;
+    command->color = color;
+    command->clip_x0 = list->clip_x0;
+    command->clip_y0 = list->clip_y0;
+    command->clip_x1 = list->clip_x1;
+    command->clip_y1 = list->clip_y1;
+
+    return command;
+}
+
+/* Draws a line clipped to the region (and framebuffer). Only the visible pixels are stepped,
+ * the inner loop is a Bresenham (midpoint) walk along the major axis without bounds tests.
+ */
+LMTYN_API void lmtyn_editor_draw_line(
+    lmtyn_editor *editor,
+    u32 region_index,
+    i32 x0,
+    i32 y0,
+    i32 x1,
+    i32 y1,
+    u32 color)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    i32 fb_w = (i32)editor->framebuffer_width;
+    i32 fb_h = (i32)editor->framebuffer_height;
+
+    i32 min_x = (i32)r->x > 0 ? (i32)r->x : 0;
+    i32 min_y = (i32)r->y > 0 ? (i32)r->y : 0;
+    i32 max_x = ((i32)(r->x + r->w) < fb_w ? (i32)(r->x + r->w) : fb_w) - 1;
+    i32 max_y = ((i32)(r->y + r->h) < fb_h ? (i32)(r->y + r->h) : fb_h) - 1;
+
+    f32 t0, t1;
+    f32 dx_f = (f32)x1 - (f32)x0;
+    f32 dy_f = (f32)y1 - (f32)y0;
+
+    lmtyn_editor_draw_command *command;
+    i32 cx0, cy0, cx1, cy1;
+
+    if (!r->dirty || min_x > max_x || min_y > max_y ||
+        !lmtyn_editor_clip_segment((f32)x0, (f32)y0, (f32)x1, (f32)y1, (f32)min_x, (f32)min_y, (f32)max_x, (f32)max_y, &t0, &t1))
+    {
+        return;
+    }
+
+    /* The end points are clamped since far away coordinates lose precision in the clip,
+     * a walk between two points inside of the rectangle never leaves it.
+     */
+    cx0 = (i32)lmtyn_roundf(lmtyn_clampf((f32)x0 + dx_f * t0, (f32)min_x, (f32)max_x));
+    cy0 = (i32)lmtyn_roundf(lmtyn_clampf((f32)y0 + dy_f * t0, (f32)min_y, (f32)max_y));
+    cx1 = (i32)lmtyn_roundf(lmtyn_clampf((f32)x0 + dx_f * t1, (f32)min_x, (f32)max_x));
+    cy1 = (i32)lmtyn_roundf(lmtyn_clampf((f32)y0 + dy_f * t1, (f32)min_y, (f32)max_y));
+
+    command = lmtyn_editor_draw_list_push(editor, region_index, LMTYN_EDITOR_DRAW_LINE, color);
+
+    if (command)
+    {
+        command->x0 = cx0;
+        command->y0 = cy0;
+        command->x1 = cx1;
+        command->y1 = cy1;
+        return;
+    }
+
+    lmtyn_editor_raster_line(editor, cx0, cy0, cx1, cy1, min_x, min_y, max_x, max_y, color);
+}
+
+LMTYN_API void lmtyn_editor_draw_circle(
+    lmtyn_editor *editor,
+    u32 region_index,
+    i32 cx,
+    i32 cy,
+    i32 radius,
+    u32 color)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    lmtyn_editor_draw_command *command;
+
+    i32 fb_w = (i32)editor->framebuffer_width;
+    i32 fb_h = (i32)editor->framebuffer_height;
+
+    /* Regions that are not redrawn keep their pixels */
+    if (!r->dirty)
+    {
+        return;
     }
+
+    command = lmtyn_editor_draw_list_push(editor, region_index, LMTYN_EDITOR_DRAW_CIRCLE, color);
+
+    if (command)
+    {
+        command->x0 = cx;
+        command->y0 = cy;
+        command->x1 = radius;
+        command->y1 = 0;
+        return;
+    }
+
+    lmtyn_editor_raster_circle(
+        editor, cx, cy, radius,
+        (i32)r->x > 0 ? (i32)r->x : 0,
+        (i32)r->y > 0 ? (i32)r->y : 0,
+        ((i32)(r->x + r->w) < fb_w ? (i32)(r->x + r->w) : fb_w) - 1,
+        ((i32)(r->y + r->h) < fb_h ? (i32)(r->y + r->h) : fb_h) - 1,
+        color);
 }
 
+/* pixels is the framebuffer or a buffer of the same layout (see grid_cache) */
 LMTYN_API void lmtyn_editor_draw_background(
     lmtyn_editor *editor,
-    u32 region_index)
+    u32 region_index,
+    u32 *pixels)
 {
     lmtyn_editor_region *r = &editor->regions[region_index];
 
@@ -1055,7 +2018,7 @@ LMTYN_API void lmtyn_editor_draw_background(
 
     for (y = r->y; y < r->y + r->h; ++y)
     {
-        u32 *row = editor->framebuffer + y * editor->framebuffer_width + r->x;
+        u32 *row = pixels + y * editor->framebuffer_width + r->x;
 
         for (x = 0; x < r->w; ++x)
         {
@@ -1072,7 +2035,8 @@ LMTYN_API void lmtyn_editor_draw_borders(
 
     if (editor->regions_selected_region_index >= 0 &&
         editor->regions_selected_region_index != LMTYN_EDITOR_REGION_MENU &&
-        editor->regions_selected_region_index != LMTYN_EDITOR_REGION_TOOLBAR)
+        editor->regions_selected_region_index != LMTYN_EDITOR_REGION_TOOLBAR &&
+        editor->regions[editor->regions_selected_region_index].dirty)
     {
         /* Selected region */
         lmtyn_editor_region *r = &editor->regions[editor->regions_selected_region_index];
@@ -1117,9 +2081,28 @@ LMTYN_API void lmtyn_editor_draw_borders(
     }
 }
 
+/* Blends two XRGB pixels with a weight of 0..256 for b, red and blue share one multiply */
+LMTYN_API LMTYN_INLINE u32 lmtyn_editor_blend(u32 a, u32 b, u32 weight)
+{
+    u32 rb = (((a & 0x00FF00FF) * (256 - weight) + (b & 0x00FF00FF) * weight) >> 8) & 0x00FF00FF;
+    u32 g = (((a & 0x0000FF00) * (256 - weight) + (b & 0x0000FF00) * weight) >> 8) & 0x0000FF00;
+
+    return rb | g;
+}
+
+/* Grid lines closer than this many pixels switch to the next coarser level (10x spacing) */
+#define LMTYN_EDITOR_GRID_SPACING_MIN 4.0f
+/* Minor lines fade in until they are this many pixels apart */
+#define LMTYN_EDITOR_GRID_SPACING_FADE 12.0f
+/* Every 10th line of a level is a major line, which is the minor line of the next level */
+#define LMTYN_EDITOR_GRID_MAJOR 10
+#define LMTYN_EDITOR_GRID_LINES_MAX 1024
+
+/* Draws the grid at the level of detail of the zoom, the number of lines is bounded by the region size */
 LMTYN_API void lmtyn_editor_draw_grid(
     lmtyn_editor *editor,
-    u32 region_index)
+    u32 region_index,
+    u32 *pixels)
 {
     lmtyn_editor_region *r = &editor->regions[region_index];
     u32 fb_w = editor->framebuffer_width;
@@ -1140,232 +2123,1008 @@ LMTYN_API void lmtyn_editor_draw_grid(
     f32 world_bottom = -half_h_units + r->grid_scroll_offset_y;
     f32 world_top = half_h_units + r->grid_scroll_offset_y;
 
-    i32 start_x = (i32)lmtyn_floorf(world_left / editor->grid_cell_size);
-    i32 end_x = (i32)lmtyn_ceilf(world_right / editor->grid_cell_size);
-    i32 start_y = (i32)lmtyn_floorf(world_bottom / editor->grid_cell_size);
-    i32 end_y = (i32)lmtyn_ceilf(world_top / editor->grid_cell_size);
+    /* Coarsen the spacing by 10x until neighbouring lines are far enough apart on both axes */
+    f32 pixels_per_unit = pixels_per_unit_x < pixels_per_unit_y ? pixels_per_unit_x : pixels_per_unit_y;
+    f32 spacing = editor->grid_cell_size;
+    f32 fade;
+    u32 color_minor;
+    u32 level;
+
+    i32 start_x, end_x, start_y, end_y;
+    i32 gx, gy;
+    u32 x, y;
+
+    i32 axis_px;
+    i32 axis_py;
+
+    for (level = 0; level < 16 && spacing * pixels_per_unit < LMTYN_EDITOR_GRID_SPACING_MIN; ++level)
+    {
+        spacing *= (f32)LMTYN_EDITOR_GRID_MAJOR;
+    }
+
+    /* Minor lines fade out as they get closer, at the next level only the former major lines remain */
+    fade = (spacing * pixels_per_unit - LMTYN_EDITOR_GRID_SPACING_MIN) / (LMTYN_EDITOR_GRID_SPACING_FADE - LMTYN_EDITOR_GRID_SPACING_MIN);
+    fade = lmtyn_clampf(fade, 0.0f, 1.0f);
+    color_minor = fade >= 1.0f ? editor->grid_color : lmtyn_editor_blend(r->color_background, editor->grid_color, (u32)(fade * 256.0f));
+
+    start_x = (i32)lmtyn_floorf(world_left / spacing);
+    end_x = (i32)lmtyn_ceilf(world_right / spacing);
+    start_y = (i32)lmtyn_floorf(world_bottom / spacing);
+    end_y = (i32)lmtyn_ceilf(world_top / spacing);
+
+    end_x = end_x - start_x > LMTYN_EDITOR_GRID_LINES_MAX ? start_x + LMTYN_EDITOR_GRID_LINES_MAX : end_x;
+    end_y = end_y - start_y > LMTYN_EDITOR_GRID_LINES_MAX ? start_y + LMTYN_EDITOR_GRID_LINES_MAX : end_y;
+
+    /* Vertical lines */
+    for (gx = start_x; gx <= end_x; ++gx)
+    {
+        f32 wx = (f32)gx * spacing;
+        i32 px = (i32)(cx + (wx - r->grid_scroll_offset_x) * pixels_per_unit_x);
+        u8 major = (gx % LMTYN_EDITOR_GRID_MAJOR) == 0;
+        u32 color = major ? editor->grid_color : color_minor;
+
+        if (px < (i32)r->x || px >= (i32)(r->x + r->w) || (!major && fade <= 0.0f))
+        {
+            continue;
+        }
+
+        for (y = r->y; y < r->y + r->h; ++y)
+        {
+            pixels[y * fb_w + (u32)px] = color;
+        }
+    }
+
+    /* Horizontal lines */
+    for (gy = start_y; gy <= end_y; ++gy)
+    {
+        f32 wy = (f32)gy * spacing;
+        i32 py = (i32)(cy - (wy - r->grid_scroll_offset_y) * pixels_per_unit_y); /* flip Y */
+        u8 major = (gy % LMTYN_EDITOR_GRID_MAJOR) == 0;
+        u32 color = major ? editor->grid_color : color_minor;
+
+        if (py < (i32)r->y || py >= (i32)(r->y + r->h) || (!major && fade <= 0.0f))
+        {
+            continue;
+        }
+
+        for (x = r->x; x < r->x + r->w; ++x)
+        {
+            pixels[(u32)py * fb_w + x] = color;
+        }
+    }
+
+    /* Axis lines at world (0,0) */
+    axis_px = (i32)(cx - r->grid_scroll_offset_x * pixels_per_unit_x);
+    axis_py = (i32)(cy + r->grid_scroll_offset_y * pixels_per_unit_y); /* Y flip */
+
+    if (axis_px >= (i32)r->x && axis_px < (i32)(r->x + r->w))
+    {
+        for (y = r->y; y < r->y + r->h; ++y)
+        {
+            pixels[y * fb_w + (u32)axis_px] = editor->grid_color_axis;
+        }
+    }
+
+    if (axis_py >= (i32)r->y && axis_py < (i32)(r->y + r->h))
+    {
+        for (x = r->x; x < r->x + r->w; ++x)
+        {
+            pixels[(u32)axis_py * fb_w + x] = editor->grid_color_axis;
+        }
+    }
+}
+
+LMTYN_API u8 lmtyn_editor_grid_key_equals(lmtyn_editor_grid_key *a, lmtyn_editor_grid_key *b)
+{
+    return a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h && a->stride == b->stride &&
+           a->color_background == b->color_background && a->color == b->color && a->color_axis == b->color_axis &&
+           a->scale == b->scale && a->cell_size == b->cell_size &&
+           a->scroll_offset_x == b->scroll_offset_x && a->scroll_offset_y == b->scroll_offset_y;
+}
+
+/* Background and grid of a 2D view. With a grid_cache they are only drawn when the view changed,
+ * otherwise the cached rows are copied.
+ */
+LMTYN_API void lmtyn_editor_draw_grid_layer(
+    lmtyn_editor *editor,
+    u32 region_index)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    lmtyn_editor_grid_key key;
+    u32 x;
+    u32 y;
+
+    if (!editor->grid_cache ||
+        (unsigned long)editor->framebuffer_width * editor->framebuffer_height * sizeof(u32) > editor->grid_cache_size)
+    {
+        lmtyn_editor_draw_background(editor, region_index, editor->framebuffer);
+        lmtyn_editor_draw_grid(editor, region_index, editor->framebuffer);
+        return;
+    }
+
+    key.x = r->x;
+    key.y = r->y;
+    key.w = r->w;
+    key.h = r->h;
+    key.stride = editor->framebuffer_width;
+    key.color_background = r->color_background;
+    key.color = editor->grid_color;
+    key.color_axis = editor->grid_color_axis;
+    key.scale = editor->grid_scale;
+    key.cell_size = editor->grid_cell_size;
+    key.scroll_offset_x = r->grid_scroll_offset_x;
+    key.scroll_offset_y = r->grid_scroll_offset_y;
+
+    if (!r->grid_cached || !lmtyn_editor_grid_key_equals(&r->grid_cache_key, &key))
+    {
+        lmtyn_editor_draw_background(editor, region_index, editor->grid_cache);
+        lmtyn_editor_draw_grid(editor, region_index, editor->grid_cache);
+        r->grid_cache_key = key;
+        r->grid_cached = 1;
+    }
+
+    for (y = r->y; y < r->y + r->h; ++y)
+    {
+        u32 *src = editor->grid_cache + y * editor->framebuffer_width + r->x;
+        u32 *dst = editor->framebuffer + y * editor->framebuffer_width + r->x;
+
+        for (x = 0; x < r->w; ++x)
+        {
+            dst[x] = src[x];
+        }
+    }
+}
+
+/* Maps a world position to the two axes shown by the region (XZ, YZ or XY view) */
+LMTYN_API LMTYN_INLINE void lmtyn_editor_region_axes(
+    u32 region_index,
+    f32 x, f32 y, f32 z, f32 *a, f32 *b)
+{
+    *a = region_index == LMTYN_EDITOR_REGION_YZ ? y : x;
+    *b = region_index == LMTYN_EDITOR_REGION_XY ? y : z;
+}
+
+/* Consecutive circles of a sweep lie close together, runs of this many circles share their bounds
+ * and groups of this many runs another one
+ */
+#define LMTYN_EDITOR_CIRCLE_BLOCK 16
+
+/* Memory needed by lmtyn_editor_circle_index_init for circles_capacity circles: the bounds of the runs
+ * followed by one pick grid per 2D view, see lmtyn_editor_circle_grid_build
+ */
+LMTYN_API unsigned long lmtyn_editor_circle_index_size(u32 circles_capacity)
+{
+    u32 blocks = (circles_capacity + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 groups = (blocks + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+
+    return (unsigned long)(blocks + groups) * 8 * sizeof(f32) +
+           3 * ((unsigned long)circles_capacity * 2 + 1) * sizeof(u32);
+}
+
+LMTYN_API LMTYN_INLINE void lmtyn_editor_bounds_add(f32 *bounds, f32 x, f32 y, f32 z, f32 radius)
+{
+    bounds[0] = x < bounds[0] ? x : bounds[0];
+    bounds[1] = y < bounds[1] ? y : bounds[1];
+    bounds[2] = z < bounds[2] ? z : bounds[2];
+    bounds[3] = x > bounds[3] ? x : bounds[3];
+    bounds[4] = y > bounds[4] ? y : bounds[4];
+    bounds[5] = z > bounds[5] ? z : bounds[5];
+    bounds[6] = radius > bounds[6] ? radius : bounds[6];
+}
+
+/* Recomputes the bounds of one run of circles, 8 floats: the box of the centers (min xyz, max xyz),
+ * the largest radius and padding. The radius is kept apart since the 2D views scale it by the view
+ * width on both axes. A run also covers the center of the circle before it since the connecting line starts there.
+ */
+LMTYN_API void lmtyn_editor_circle_index_refit_block(lmtyn_editor *editor, u32 block)
+{
+    f32 *bounds = editor->circles_bounds + block * 8;
+    u32 first = block * LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 last = first + LMTYN_EDITOR_CIRCLE_BLOCK < editor->circles_count ? first + LMTYN_EDITOR_CIRCLE_BLOCK : editor->circles_count;
+    u32 c;
+
+    bounds[0] = bounds[1] = bounds[2] = 1e30f;
+    bounds[3] = bounds[4] = bounds[5] = -1e30f;
+    bounds[6] = bounds[7] = 0.0f;
+
+    if (first > 0 && first < last)
+    {
+        lmtyn_shape_circle *prev = &editor->circles[first - 1];
+        lmtyn_editor_bounds_add(bounds, prev->center_x, prev->center_y, prev->center_z, 0.0f);
+    }
+
+    for (c = first; c < last; ++c)
+    {
+        lmtyn_shape_circle *circle = &editor->circles[c];
+        lmtyn_editor_bounds_add(bounds, circle->center_x, circle->center_y, circle->center_z, circle->radius);
+    }
+}
+
+/* Recomputes the bounds of a group of runs from the bounds of its runs */
+LMTYN_API void lmtyn_editor_circle_index_refit_group(lmtyn_editor *editor, u32 group)
+{
+    f32 *bounds = editor->circles_bounds + (editor->circles_bounds_blocks + group) * 8;
+    u32 blocks_count = (editor->circles_count + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 first = group * LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 last = first + LMTYN_EDITOR_CIRCLE_BLOCK < blocks_count ? first + LMTYN_EDITOR_CIRCLE_BLOCK : blocks_count;
+    u32 b;
+
+    bounds[0] = bounds[1] = bounds[2] = 1e30f;
+    bounds[3] = bounds[4] = bounds[5] = -1e30f;
+    bounds[6] = bounds[7] = 0.0f;
+
+    for (b = first; b < last; ++b)
+    {
+        f32 *block = editor->circles_bounds + b * 8;
+
+        lmtyn_editor_bounds_add(bounds, block[0], block[1], block[2], block[6]);
+        lmtyn_editor_bounds_add(bounds, block[3], block[4], block[5], block[6]);
+    }
+}
+
+/* The runs follow the sweep and only cull well while it does not fold back onto itself. Picking
+ * therefore sorts the circle centers of each 2D view into a uniform grid of about one circle per
+ * cell that does not depend on the order of the circles. A grid is rebuilt by the first pick in its
+ * view after the circles changed, dragging a circle does not pick.
+ */
+LMTYN_API LMTYN_INLINE void lmtyn_editor_circle_grid_invalidate(lmtyn_editor *editor)
+{
+    editor->circles_grid_cells[0] = 0;
+    editor->circles_grid_cells[1] = 0;
+    editor->circles_grid_cells[2] = 0;
+}
+
+LMTYN_API LMTYN_INLINE u32 *lmtyn_editor_circle_grid_offsets(lmtyn_editor *editor, u32 region_index)
+{
+    return editor->circles_grid + region_index * (editor->circles_capacity * 2 + 1);
+}
+
+/* Cell of a view position along one axis, positions outside of the grid (or NaN) map to the border cells */
+LMTYN_API LMTYN_INLINE u32 lmtyn_editor_circle_grid_cell(f32 value, f32 min, f32 scale, u32 cells)
+{
+    f32 cell = (value - min) * scale;
+
+    return !(cell > 0.0f) ? 0 : (cell >= (f32)(cells - 1) ? cells - 1 : (u32)cell);
+}
+
+/* Counting sort of the circle centers of a 2D view by grid cell, circles keep their order within a cell */
+LMTYN_API void lmtyn_editor_circle_grid_build(lmtyn_editor *editor, u32 region_index)
+{
+    u32 *offsets = lmtyn_editor_circle_grid_offsets(editor, region_index);
+    u32 *sorted = offsets + editor->circles_capacity + 1;
+    f32 *min = editor->circles_grid_min[region_index];
+    f32 *scale = editor->circles_grid_scale[region_index];
+    f32 max[2];
+    u32 cells = 1;
+    u32 c, i;
+
+    min[0] = min[1] = 1e30f;
+    max[0] = max[1] = -1e30f;
+
+    for (c = 0; c < editor->circles_count; ++c)
+    {
+        lmtyn_shape_circle *circle = &editor->circles[c];
+        f32 a, b;
+
+        lmtyn_editor_region_axes(region_index, circle->center_x, circle->center_y, circle->center_z, &a, &b);
+
+        min[0] = a < min[0] ? a : min[0];
+        min[1] = b < min[1] ? b : min[1];
+        max[0] = a > max[0] ? a : max[0];
+        max[1] = b > max[1] ? b : max[1];
+    }
+
+    while ((cells + 1) * (cells + 1) <= editor->circles_count)
+    {
+        ++cells;
+    }
+
+    scale[0] = max[0] > min[0] ? (f32)cells / (max[0] - min[0]) : 0.0f;
+    scale[1] = max[1] > min[1] ? (f32)cells / (max[1] - min[1]) : 0.0f;
+
+    for (i = 0; i <= cells * cells; ++i)
+    {
+        offsets[i] = 0;
+    }
+
+    for (c = 0; c < editor->circles_count; ++c)
+    {
+        lmtyn_shape_circle *circle = &editor->circles[c];
+        f32 a, b;
+
+        lmtyn_editor_region_axes(region_index, circle->center_x, circle->center_y, circle->center_z, &a, &b);
+        offsets[lmtyn_editor_circle_grid_cell(b, min[1], scale[1], cells) * cells + lmtyn_editor_circle_grid_cell(a, min[0], scale[0], cells) + 1]++;
+    }
+
+    for (i = 1; i <= cells * cells; ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    /* Every cell offset moves to the end of its cell while placing, afterwards they are shifted back */
+    for (c = 0; c < editor->circles_count; ++c)
+    {
+        lmtyn_shape_circle *circle = &editor->circles[c];
+        f32 a, b;
+
+        lmtyn_editor_region_axes(region_index, circle->center_x, circle->center_y, circle->center_z, &a, &b);
+        sorted[offsets[lmtyn_editor_circle_grid_cell(b, min[1], scale[1], cells) * cells + lmtyn_editor_circle_grid_cell(a, min[0], scale[0], cells)]++] = c;
+    }
+
+    for (i = cells * cells; i > 0; --i)
+    {
+        offsets[i] = offsets[i - 1];
+    }
+
+    offsets[0] = 0;
+    editor->circles_grid_cells[region_index] = cells;
+}
+
+/* Builds the grid of the view if needed and returns the cells covering the screen rectangle.
+ * One more cell on each side keeps circles on cell borders despite rounding.
+ */
+LMTYN_API void lmtyn_editor_circle_grid_range(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 x0, f32 y0, f32 x1, f32 y1,
+    u32 *cell_a0, u32 *cell_b0, u32 *cell_a1, u32 *cell_b1)
+{
+    f32 *min = editor->circles_grid_min[region_index];
+    f32 *scale = editor->circles_grid_scale[region_index];
+    f32 a0, b0, a1, b1;
+    u32 cells;
+
+    if (!editor->circles_grid_cells[region_index])
+    {
+        lmtyn_editor_circle_grid_build(editor, region_index);
+    }
+
+    cells = editor->circles_grid_cells[region_index];
+
+    lmtyn_editor_screen_to_world_f32(editor, region_index, x0, y0, &a0, &b0);
+    lmtyn_editor_screen_to_world_f32(editor, region_index, x1, y1, &a1, &b1);
+
+    /* The XY view flips its vertical axis */
+    if (b0 > b1)
+    {
+        f32 t = b0;
+        b0 = b1;
+        b1 = t;
+    }
+
+    *cell_a0 = lmtyn_editor_circle_grid_cell(a0, min[0], scale[0], cells);
+    *cell_b0 = lmtyn_editor_circle_grid_cell(b0, min[1], scale[1], cells);
+    *cell_a1 = lmtyn_editor_circle_grid_cell(a1, min[0], scale[0], cells);
+    *cell_b1 = lmtyn_editor_circle_grid_cell(b1, min[1], scale[1], cells);
+
+    *cell_a0 = *cell_a0 > 0 ? *cell_a0 - 1 : 0;
+    *cell_b0 = *cell_b0 > 0 ? *cell_b0 - 1 : 0;
+    *cell_a1 = *cell_a1 + 1 < cells ? *cell_a1 + 1 : cells - 1;
+    *cell_b1 = *cell_b1 + 1 < cells ? *cell_b1 + 1 : cells - 1;
+}
+
+/* Recomputes all bounds, edits of single circles only need lmtyn_editor_circle_index_update_circle */
+LMTYN_API void lmtyn_editor_circle_index_update(lmtyn_editor *editor)
+{
+    u32 blocks_count = (editor->circles_count + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 groups_count = (blocks_count + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 i;
+
+    if (!editor->circles_bounds || editor->circles_count > editor->circles_capacity)
+    {
+        editor->circles_bounds_count = 0;
+        return;
+    }
+
+    lmtyn_editor_circle_grid_invalidate(editor);
+
+    for (i = 0; i < blocks_count; ++i)
+    {
+        lmtyn_editor_circle_index_refit_block(editor, i);
+    }
+
+    for (i = 0; i < groups_count; ++i)
+    {
+        lmtyn_editor_circle_index_refit_group(editor, i);
+    }
+
+    editor->circles_bounds_count = editor->circles_count;
+}
+
+/* Updates the bounds after circle i moved, or was appended or removed as the last circle.
+ * Only the runs containing the circle and its connecting line and their groups are refitted.
+ */
+LMTYN_API void lmtyn_editor_circle_index_update_circle(lmtyn_editor *editor, u32 i)
+{
+    u32 block = i / LMTYN_EDITOR_CIRCLE_BLOCK;
+
+    if (!editor->circles_bounds || editor->circles_count > editor->circles_capacity)
+    {
+        editor->circles_bounds_count = 0;
+        return;
+    }
+
+    /* More than one circle was added or removed since the last update */
+    if (editor->circles_bounds_count + 1 < editor->circles_count || editor->circles_count + 1 < editor->circles_bounds_count)
+    {
+        lmtyn_editor_circle_index_update(editor);
+        return;
+    }
+
+    lmtyn_editor_circle_grid_invalidate(editor);
+
+    lmtyn_editor_circle_index_refit_block(editor, block);
+    lmtyn_editor_circle_index_refit_group(editor, block / LMTYN_EDITOR_CIRCLE_BLOCK);
+
+    /* The next run starts with the line from this center */
+    if ((i + 1) % LMTYN_EDITOR_CIRCLE_BLOCK == 0 && block + 1 < editor->circles_bounds_blocks)
+    {
+        lmtyn_editor_circle_index_refit_block(editor, block + 1);
+        lmtyn_editor_circle_index_refit_group(editor, (block + 1) / LMTYN_EDITOR_CIRCLE_BLOCK);
+    }
+
+    editor->circles_bounds_count = editor->circles_count;
+}
+
+/* Attaches the bounds used to cull circles and the pick grids, returns 0 if the memory does not cover circles_capacity */
+LMTYN_API u8 lmtyn_editor_circle_index_init(lmtyn_editor *editor, void *memory, unsigned long memory_size)
+{
+    u32 groups;
+
+    editor->circles_bounds = 0;
+    editor->circles_bounds_blocks = 0;
+    editor->circles_bounds_count = 0;
+    editor->circles_grid = 0;
+
+    if (!memory || memory_size < lmtyn_editor_circle_index_size(editor->circles_capacity))
+    {
+        return 0;
+    }
+
+    editor->circles_bounds = (f32 *)memory;
+    editor->circles_bounds_blocks = (editor->circles_capacity + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+
+    groups = (editor->circles_bounds_blocks + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    editor->circles_grid = (u32 *)(editor->circles_bounds + (editor->circles_bounds_blocks + groups) * 8);
+
+    lmtyn_editor_circle_index_update(editor);
+
+    return 1;
+}
+
+/* Circles whose outline projects below this many pixels only get a point, the selected one a cross */
+#define LMTYN_EDITOR_CIRCLE_LOD_RADIUS 2
+/* Half size of the cross lmtyn_editor_draw_circle draws at the center */
+#define LMTYN_EDITOR_CIRCLE_CROSS_SIZE 6
+
+/* Draws the circles first..last-1 and the lines to their predecessors into a 2D view */
+LMTYN_API void lmtyn_editor_draw_circles_range(lmtyn_editor *editor, u32 region_index, u32 first, u32 last)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    f32 pixels_per_unit = (f32)r->w / (2.0f * editor->grid_scale);
+    u32 c;
+
+    for (c = first; c < last; ++c)
+    {
+        lmtyn_shape_circle *circle = &editor->circles[c];
+        lmtyn_shape_circle *circle_prev = (c > 0) ? &editor->circles[c - 1] : (void *)0;
+        u8 selected = c == editor->circles_selected_circle_index;
+        u8 hovered = c == editor->circles_hovered_circle_index;
+
+        f32 a, b;
+
+        u32 px;
+        u32 py;
+        u32 pr;
+        i32 extent;
+
+        lmtyn_editor_region_axes(region_index, circle->center_x, circle->center_y, circle->center_z, &a, &b);
+        lmtyn_editor_world_to_screen(editor, region_index, a, b, &px, &py);
+
+        pr = (u32)(circle->radius * pixels_per_unit);
+
+        if (circle_prev)
+        {
+            f32 a_prev, b_prev;
+            u32 px_prev;
+            u32 py_prev;
+
+            lmtyn_editor_region_axes(region_index, circle_prev->center_x, circle_prev->center_y, circle_prev->center_z, &a_prev, &b_prev);
+            lmtyn_editor_world_to_screen(editor, region_index, a_prev, b_prev, &px_prev, &py_prev);
+
+            lmtyn_editor_draw_line(editor, region_index, (i32)px_prev, (i32)py_prev, (i32)px, (i32)py, editor->circles_color_line);
+        }
+
+        /* Skip circles whose outline and cross are outside of the view */
+        extent = (i32)pr > LMTYN_EDITOR_CIRCLE_CROSS_SIZE ? (i32)pr : LMTYN_EDITOR_CIRCLE_CROSS_SIZE;
+
+        if ((i32)px + extent < (i32)r->x || (i32)px - extent >= (i32)(r->x + r->w) ||
+            (i32)py + extent < (i32)r->y || (i32)py - extent >= (i32)(r->y + r->h))
+        {
+            continue;
+        }
+
+        if (pr < LMTYN_EDITOR_CIRCLE_LOD_RADIUS && !selected && !hovered)
+        {
+            if ((i32)px >= (i32)r->x && (i32)px < (i32)(r->x + r->w) &&
+                (i32)py >= (i32)r->y && (i32)py < (i32)(r->y + r->h) && r->dirty)
+            {
+                lmtyn_editor_draw_command *command = lmtyn_editor_draw_list_push(editor, region_index, LMTYN_EDITOR_DRAW_POINT, editor->circles_color);
+
+                if (command)
+                {
+                    command->x0 = (i32)px;
+                    command->y0 = (i32)py;
+                }
+                else
+                {
+                    editor->framebuffer[py * editor->framebuffer_width + px] = editor->circles_color;
+                }
+            }
+
+            continue;
+        }
+
+        lmtyn_editor_draw_circle(
+            editor, region_index, (i32)px, (i32)py, (i32)pr,
+            selected
+                ? editor->circles_color_selected
+            : hovered
+                ? editor->circles_color_hovered
+                : editor->circles_color);
+    }
+}
+
+/* Tests circle bounds (see lmtyn_editor_circle_index_update) against the visible area of a 2D view */
+LMTYN_API LMTYN_INLINE u8 lmtyn_editor_bounds_visible(lmtyn_editor *editor, u32 region_index, f32 *bounds)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    f32 pixels_per_unit_x = (f32)r->w / (2.0f * editor->grid_scale);
+    f32 pixels_per_unit_y = (f32)r->h / (2.0f * editor->grid_scale);
+    f32 min_a, min_b, max_a, max_b;
+    f32 extent_a, extent_b;
+
+    /* Outline or cross around the centers, one more pixel for the truncation to the pixel grid */
+    f32 extent = bounds[6] * pixels_per_unit_x;
+    extent = (extent > (f32)LMTYN_EDITOR_CIRCLE_CROSS_SIZE ? extent : (f32)LMTYN_EDITOR_CIRCLE_CROSS_SIZE) + 1.0f;
 
-    i32 gx, gy;
-    u32 x, y;
+    extent_a = editor->grid_scale + extent / pixels_per_unit_x;
+    extent_b = editor->grid_scale + extent / pixels_per_unit_y;
 
-    i32 axis_px;
-    i32 axis_py;
+    lmtyn_editor_region_axes(region_index, bounds[0], bounds[1], bounds[2], &min_a, &min_b);
+    lmtyn_editor_region_axes(region_index, bounds[3], bounds[4], bounds[5], &max_a, &max_b);
 
-    /* Vertical lines */
-    for (gx = start_x; gx <= end_x; ++gx)
+    return max_a >= r->grid_scroll_offset_x - extent_a && min_a <= r->grid_scroll_offset_x + extent_a &&
+           max_b >= r->grid_scroll_offset_y - extent_b && min_b <= r->grid_scroll_offset_y + extent_b;
+}
+
+/* Only the runs of circles whose bounds reach into the view are drawn, see lmtyn_editor_circle_index_update */
+LMTYN_API void lmtyn_editor_draw_circles(lmtyn_editor *editor, u32 region_index)
+{
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    u32 blocks_count = (editor->circles_count + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 groups_count = (blocks_count + LMTYN_EDITOR_CIRCLE_BLOCK - 1) / LMTYN_EDITOR_CIRCLE_BLOCK;
+    u32 g, b;
+
+    if (!editor->circles_bounds || editor->circles_bounds_count != editor->circles_count || r->w < 1 || r->h < 1)
     {
-        f32 wx = gx * editor->grid_cell_size;
-        i32 px = (i32)(cx + (wx - r->grid_scroll_offset_x) * pixels_per_unit_x);
+        lmtyn_editor_draw_circles_range(editor, region_index, 0, editor->circles_count);
+        return;
+    }
+
+    for (g = 0; g < groups_count; ++g)
+    {
+        u32 blocks_end = (g + 1) * LMTYN_EDITOR_CIRCLE_BLOCK < blocks_count ? (g + 1) * LMTYN_EDITOR_CIRCLE_BLOCK : blocks_count;
 
-        if (px < (i32)r->x || px >= (i32)(r->x + r->w))
+        if (!lmtyn_editor_bounds_visible(editor, region_index, editor->circles_bounds + (editor->circles_bounds_blocks + g) * 8))
         {
             continue;
         }
 
-        for (y = r->y; y < r->y + r->h; ++y)
+        for (b = g * LMTYN_EDITOR_CIRCLE_BLOCK; b < blocks_end; ++b)
         {
-            editor->framebuffer[y * fb_w + px] = editor->grid_color;
+            u32 first = b * LMTYN_EDITOR_CIRCLE_BLOCK;
+            u32 last = first + LMTYN_EDITOR_CIRCLE_BLOCK < editor->circles_count ? first + LMTYN_EDITOR_CIRCLE_BLOCK : editor->circles_count;
+
+            if (lmtyn_editor_bounds_visible(editor, region_index, editor->circles_bounds + b * 8))
+            {
+                lmtyn_editor_draw_circles_range(editor, region_index, first, last);
+            }
         }
     }
+}
 
-    /* Horizontal lines */
-    for (gy = start_y; gy <= end_y; ++gy)
+/* Screen position of the center of circle c in a 2D view */
+LMTYN_API LMTYN_INLINE void lmtyn_editor_circle_to_screen(lmtyn_editor *editor, u32 region_index, u32 c, f32 *sx, f32 *sy)
+{
+    lmtyn_shape_circle *circle = &editor->circles[c];
+    f32 a, b;
+
+    lmtyn_editor_region_axes(region_index, circle->center_x, circle->center_y, circle->center_z, &a, &b);
+    lmtyn_editor_world_to_screen_f32(editor, region_index, a, b, sx, sy);
+}
+
+LMTYN_API void lmtyn_editor_circles_nearest_range(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 x, f32 y,
+    u32 first, u32 last,
+    u32 *nearest, f32 *nearest_distance_squared)
+{
+    u32 c;
+
+    for (c = first; c < last; ++c)
     {
-        f32 wy = gy * editor->grid_cell_size;
-        i32 py = (i32)(cy - (wy - r->grid_scroll_offset_y) * pixels_per_unit_y); /* flip Y */
+        f32 sx, sy, d;
+
+        lmtyn_editor_circle_to_screen(editor, region_index, c, &sx, &sy);
 
-        if (py < (i32)r->y || py >= (i32)(r->y + r->h))
+        d = (sx - x) * (sx - x) + (sy - y) * (sy - y);
+
+        /* Later circles are drawn on top and win ties */
+        if (d <= *nearest_distance_squared)
         {
-            continue;
+            *nearest = c;
+            *nearest_distance_squared = d;
         }
+    }
+}
 
-        for (x = r->x; x < r->x + r->w; ++x)
+/* Returns the circle whose center is closest to the screen position x, y in a 2D view and at most
+ * distance_max pixels away, or LMTYN_EDITOR_CIRCLE_NONE. With the circle index only the grid cells
+ * within distance_max are visited.
+ */
+LMTYN_API u32 lmtyn_editor_circles_nearest(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 x, f32 y,
+    f32 distance_max)
+{
+    u32 nearest = LMTYN_EDITOR_CIRCLE_NONE;
+    f32 nearest_distance_squared = distance_max * distance_max;
+    u32 *offsets, *sorted;
+    u32 cell_a0, cell_b0, cell_a1, cell_b1;
+    u32 cell_a, cell_b, i;
+
+    if (!editor->circles_bounds || editor->circles_bounds_count != editor->circles_count || editor->circles_count == 0)
+    {
+        lmtyn_editor_circles_nearest_range(editor, region_index, x, y, 0, editor->circles_count, &nearest, &nearest_distance_squared);
+        return nearest;
+    }
+
+    lmtyn_editor_circle_grid_range(editor, region_index, x - distance_max, y - distance_max, x + distance_max, y + distance_max, &cell_a0, &cell_b0, &cell_a1, &cell_b1);
+
+    offsets = lmtyn_editor_circle_grid_offsets(editor, region_index);
+    sorted = offsets + editor->circles_capacity + 1;
+
+    for (cell_b = cell_b0; cell_b <= cell_b1; ++cell_b)
+    {
+        for (cell_a = cell_a0; cell_a <= cell_a1; ++cell_a)
         {
-            editor->framebuffer[py * fb_w + x] = editor->grid_color;
+            u32 cell = cell_b * editor->circles_grid_cells[region_index] + cell_a;
+
+            for (i = offsets[cell]; i < offsets[cell + 1]; ++i)
+            {
+                u32 c = sorted[i];
+                f32 sx, sy, d;
+
+                lmtyn_editor_circle_to_screen(editor, region_index, c, &sx, &sy);
+
+                d = (sx - x) * (sx - x) + (sy - y) * (sy - y);
+
+                /* Same result as the scan in circle order, later circles win ties */
+                if (d < nearest_distance_squared || (d == nearest_distance_squared && (nearest == LMTYN_EDITOR_CIRCLE_NONE || c > nearest)))
+                {
+                    nearest = c;
+                    nearest_distance_squared = d;
+                }
+            }
         }
     }
 
-    /* Axis lines at world (0,0) */
-    axis_px = (i32)(cx - r->grid_scroll_offset_x * pixels_per_unit_x);
-    axis_py = (i32)(cy + r->grid_scroll_offset_y * pixels_per_unit_y); /* Y flip */
+    return nearest;
+}
 
-    if (axis_px >= (i32)r->x && axis_px < (i32)(r->x + r->w))
+LMTYN_API u32 lmtyn_editor_circles_in_rect_range(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 x0, f32 y0, f32 x1, f32 y1,
+    u32 first, u32 last,
+    u32 *circles, u32 circles_capacity, u32 count)
+{
+    u32 c;
+
+    for (c = first; c < last && count < circles_capacity; ++c)
     {
-        for (y = r->y; y < r->y + r->h; ++y)
+        f32 sx, sy;
+
+        lmtyn_editor_circle_to_screen(editor, region_index, c, &sx, &sy);
+
+        if (sx >= x0 && sx <= x1 && sy >= y0 && sy <= y1)
         {
-            editor->framebuffer[y * fb_w + axis_px] = editor->grid_color_axis;
+            circles[count++] = c;
         }
     }
 
-    if (axis_py >= (i32)r->y && axis_py < (i32)(r->y + r->h))
+    return count;
+}
+
+/* Shell sort of a few circle indices in ascending order */
+LMTYN_API void lmtyn_editor_sort_u32(u32 *values, u32 count)
+{
+    u32 gap, i, j;
+
+    for (gap = count / 2; gap > 0; gap = gap == 2 ? 1 : gap * 5 / 11)
     {
-        for (x = r->x; x < r->x + r->w; ++x)
+        for (i = gap; i < count; ++i)
         {
-            editor->framebuffer[axis_py * fb_w + x] = editor->grid_color_axis;
+            u32 value = values[i];
+
+            for (j = i; j >= gap && values[j - gap] > value; j -= gap)
+            {
+                values[j] = values[j - gap];
+            }
+
+            values[j] = value;
         }
     }
 }
 
-LMTYN_API void lmtyn_editor_draw_circles(lmtyn_editor *editor)
+/* Writes the indices of the circles whose centers lie in the screen rectangle x0, y0 to x1, y1 of a
+ * 2D view to circles in ascending order and returns how many were written, at most circles_capacity.
+ */
+LMTYN_API u32 lmtyn_editor_circles_in_rect(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 x0, f32 y0, f32 x1, f32 y1,
+    u32 *circles, u32 circles_capacity)
 {
-    u32 i;
-    u32 c;
+    u32 count = 0;
+    u32 *offsets, *sorted;
+    u32 cell_a0, cell_b0, cell_a1, cell_b1;
+    u32 cell_a, cell_b, i;
 
-    for (i = 0; i < LMTYN_EDITOR_REGION_COUNT - 3; ++i)
+    if (x0 > x1)
     {
-        lmtyn_editor_region *r = &editor->regions[i];
+        f32 t = x0;
+        x0 = x1;
+        x1 = t;
+    }
 
-        for (c = 0; c < editor->circles_count; ++c)
-        {
-            lmtyn_shape_circle *circle = &editor->circles[c];
-            lmtyn_shape_circle *circle_prev = (c > 0) ? &editor->circles[c - 1] : (void *)0;
+    if (y0 > y1)
+    {
+        f32 t = y0;
+        y0 = y1;
+        y1 = t;
+    }
 
-            f32 a = 0.0f;
-            f32 b = 0.0f;
+    if (!editor->circles_bounds || editor->circles_bounds_count != editor->circles_count || editor->circles_count == 0)
+    {
+        return lmtyn_editor_circles_in_rect_range(editor, region_index, x0, y0, x1, y1, 0, editor->circles_count, circles, circles_capacity, 0);
+    }
 
-            f32 a_prev = 0.0f;
-            f32 b_prev = 0.0f;
+    lmtyn_editor_circle_grid_range(editor, region_index, x0, y0, x1, y1, &cell_a0, &cell_b0, &cell_a1, &cell_b1);
 
-            u32 px;
-            u32 py;
-            u32 pr;
+    offsets = lmtyn_editor_circle_grid_offsets(editor, region_index);
+    sorted = offsets + editor->circles_capacity + 1;
 
-            if (i == LMTYN_EDITOR_REGION_XZ)
-            {
-                a = circle->center_x;
-                b = circle->center_z;
+    for (cell_b = cell_b0; cell_b <= cell_b1; ++cell_b)
+    {
+        for (cell_a = cell_a0; cell_a <= cell_a1; ++cell_a)
+        {
+            u32 cell = cell_b * editor->circles_grid_cells[region_index] + cell_a;
 
-                if (circle_prev)
-                {
-                    a_prev = circle_prev->center_x;
-                    b_prev = circle_prev->center_z;
-                }
-            }
-            else if (i == LMTYN_EDITOR_REGION_YZ)
+            for (i = offsets[cell]; i < offsets[cell + 1]; ++i)
             {
-                a = circle->center_y;
-                b = circle->center_z;
+                f32 sx, sy;
 
-                if (circle_prev)
-                {
-                    a_prev = circle_prev->center_y;
-                    b_prev = circle_prev->center_z;
-                }
-            }
-            else if (i == LMTYN_EDITOR_REGION_XY)
-            {
-                a = circle->center_x;
-                b = circle->center_y;
+                lmtyn_editor_circle_to_screen(editor, region_index, sorted[i], &sx, &sy);
 
-                if (circle_prev)
+                if (sx >= x0 && sx <= x1 && sy >= y0 && sy <= y1)
                 {
-                    a_prev = circle_prev->center_x;
-                    b_prev = circle_prev->center_y;
+                    /* More circles than fit, the ones with the lowest indices come from a scan in circle order */
+                    if (count == circles_capacity)
+                    {
+                        return lmtyn_editor_circles_in_rect_range(editor, region_index, x0, y0, x1, y1, 0, editor->circles_count, circles, circles_capacity, 0);
+                    }
+
+                    circles[count++] = sorted[i];
                 }
             }
+        }
+    }
 
-            lmtyn_editor_world_to_screen(editor, i, a, b, &px, &py);
+    lmtyn_editor_sort_u32(circles, count);
 
-            pr = (u32)(circle->radius * (r->w / (2.0f * editor->grid_scale)));
+    return count;
+}
 
-            if (circle_prev)
-            {
+/* Characters of the 2D views go through their draw lists */
+LMTYN_API void lmtyn_editor_draw_region_character(
+    lmtyn_editor *editor,
+    u32 region_index,
+    u32 x, u32 y, u8 c, u32 color_fg)
+{
+    lmtyn_editor_draw_command *command = lmtyn_editor_draw_list_push(editor, region_index, LMTYN_EDITOR_DRAW_CHARACTER, color_fg);
 
-                u32 px_prev;
-                u32 py_prev;
-                lmtyn_editor_world_to_screen(editor, i, a_prev, b_prev, &px_prev, &py_prev);
+    if (command)
+    {
+        command->x0 = (i32)x;
+        command->y0 = (i32)y;
+        command->x1 = (i32)c;
+        command->y1 = 0;
+        return;
+    }
 
-                lmtyn_editor_draw_line(editor, i, px_prev, py_prev, px, py, editor->circles_color_line);
-            }
+    lmtyn_editor_draw_character(editor, x, y, c, color_fg);
+}
 
-            lmtyn_editor_draw_circle(
-                editor, i, px, py, pr,
-                c == editor->circles_selected_circle_index
-                    ? editor->circles_color_selected
-                    : editor->circles_color);
-        }
+LMTYN_API void lmtyn_editor_draw_region_label(lmtyn_editor *editor, u32 region_index)
+{
+    lmtyn_editor_region *region = &editor->regions[region_index];
+
+    u8 axis_up = 'Z';
+    u8 axis_right = 'X';
+
+    if (!region->dirty)
+    {
+        return;
+    }
+
+    if (region_index == LMTYN_EDITOR_REGION_YZ)
+    {
+        axis_right = 'Y';
+    }
+
+    if (region_index == LMTYN_EDITOR_REGION_XY)
+    {
+        axis_up = 'Y';
     }
+
+    lmtyn_editor_draw_region_character(
+        editor, region_index,
+        region->x + 25, region->y + region->h - 20,
+        axis_right,
+        editor->grid_color_axis);
+
+    lmtyn_editor_draw_region_character(
+        editor, region_index,
+        region->x + 5, region->y + region->h - 40,
+        axis_up,
+        editor->grid_color_axis);
 }
 
-LMTYN_API void lmtyn_editor_draw_region_labels(lmtyn_editor *editor)
+/* Maps count vertices (3 floats each) to the screen positions of lmtyn_editor_world_to_screen in a 2D view.
+ * The results are stored as separate x and y arrays.
+ */
+LMTYN_API void lmtyn_editor_project_vertices(
+    lmtyn_editor *editor,
+    u32 region_index,
+    f32 *vertices,
+    u32 count,
+    i32 *xs,
+    i32 *ys)
 {
-    u32 i;
+    lmtyn_editor_region *r = &editor->regions[region_index];
+    u32 axis_a = region_index == LMTYN_EDITOR_REGION_YZ ? 1 : 0;
+    u32 axis_b = region_index == LMTYN_EDITOR_REGION_XY ? 1 : 2;
+    u32 i = 0;
 
-    for (i = 0; i < LMTYN_EDITOR_REGION_COUNT - 2; ++i)
+#ifdef LMTYN_EDITOR_USE_SSE2
     {
-        lmtyn_editor_region *region = &editor->regions[i];
+        __m128 offset_x = _mm_set1_ps(r->grid_scroll_offset_x);
+        __m128 offset_y = _mm_set1_ps(r->grid_scroll_offset_y);
+        __m128 scale = _mm_set1_ps(editor->grid_scale);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128 width = _mm_set1_ps((f32)r->w);
+        __m128 height = _mm_set1_ps((f32)r->h);
+        __m128 flip = _mm_set1_ps(region_index == LMTYN_EDITOR_REGION_XY ? -0.0f : 0.0f);
+        __m128i origin_x = _mm_set1_epi32((i32)r->x);
+        __m128i origin_y = _mm_set1_epi32((i32)r->y);
+
+        /* Same operations in the same order as the scalar loop, four vertices at once */
+        for (; i + 4 <= count; i += 4)
+        {
+            f32 *v = vertices + i * 3;
+            __m128 a = _mm_setr_ps(v[axis_a], v[3 + axis_a], v[6 + axis_a], v[9 + axis_a]);
+            __m128 b = _mm_setr_ps(v[axis_b], v[3 + axis_b], v[6 + axis_b], v[9 + axis_b]);
+            __m128 nx = _mm_div_ps(_mm_sub_ps(a, offset_x), scale);
+            __m128 ny = _mm_xor_ps(_mm_div_ps(_mm_sub_ps(b, offset_y), scale), flip);
 
-        u8 axis_up = 'Z';
-        u8 axis_right = 'X';
+            nx = _mm_add_ps(_mm_mul_ps(nx, half), half);
+            ny = _mm_add_ps(_mm_mul_ps(ny, half), half);
 
-        if (i == LMTYN_EDITOR_REGION_YZ)
-        {
-            axis_right = 'Y';
+            _mm_storeu_si128((__m128i *)(xs + i), _mm_add_epi32(origin_x, _mm_cvttps_epi32(_mm_mul_ps(nx, width))));
+            _mm_storeu_si128((__m128i *)(ys + i), _mm_add_epi32(origin_y, _mm_cvttps_epi32(_mm_mul_ps(ny, height))));
         }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        f32 *v = vertices + i * 3;
+        f32 nx = (v[axis_a] - r->grid_scroll_offset_x) / editor->grid_scale;
+        f32 ny = (v[axis_b] - r->grid_scroll_offset_y) / editor->grid_scale;
 
-        if (i == LMTYN_EDITOR_REGION_XY)
+        if (region_index == LMTYN_EDITOR_REGION_XY)
         {
-            axis_up = 'Y';
+            ny = -ny;
         }
 
-        lmtyn_editor_draw_character(
-            editor,
-            region->x + 25, region->y + region->h - 20,
-            axis_right,
-            editor->grid_color_axis);
+        nx = (nx * 0.5f) + 0.5f;
+        ny = (ny * 0.5f) + 0.5f;
+
+        xs[i] = (i32)r->x + (i32)(nx * (f32)r->w);
+        ys[i] = (i32)r->y + (i32)(ny * (f32)r->h);
+    }
+}
+
+/* xs and ys are the projected vertices of the region, without them the edge is projected here */
+LMTYN_API void lmtyn_editor_draw_mesh_edge(lmtyn_editor *editor, u32 region_index, i32 *xs, i32 *ys, u32 i0, u32 i1)
+{
+    f32 *v0 = &editor->mesh->vertices[i0 * 3];
+    f32 *v1 = &editor->mesh->vertices[i1 * 3];
 
-        lmtyn_editor_draw_character(
-            editor,
-            region->x + 5, region->y + region->h - 40,
-            axis_up,
-            editor->grid_color_axis);
+    f32 a0, b0, a1, b1;
+    u32 sx0, sy0, sx1, sy1;
+
+    if (xs)
+    {
+        lmtyn_editor_draw_line(editor, region_index, xs[i0], ys[i0], xs[i1], ys[i1], editor->mesh_color_wireframe);
+        return;
     }
+
+    /* Draw the projection into the region */
+    lmtyn_editor_region_axes(region_index, v0[0], v0[1], v0[2], &a0, &b0);
+    lmtyn_editor_region_axes(region_index, v1[0], v1[1], v1[2], &a1, &b1);
+    lmtyn_editor_world_to_screen(editor, region_index, a0, b0, &sx0, &sy0);
+    lmtyn_editor_world_to_screen(editor, region_index, a1, b1, &sx1, &sy1);
+    lmtyn_editor_draw_line(editor, region_index, (i32)sx0, (i32)sy0, (i32)sx1, (i32)sy1, editor->mesh_color_wireframe);
 }
 
-LMTYN_API void lmtyn_editor_draw_mesh_wireframe(lmtyn_editor *editor)
+/* Draws every edge of the mesh once using the edge list of lmtyn_mesh_generate.
+ * Meshes without an edge list fall back to the three edges of every triangle.
+ */
+LMTYN_API void lmtyn_editor_draw_mesh_wireframe(lmtyn_editor *editor, u32 region_index)
 {
     lmtyn_mesh *mesh = editor->mesh;
+    i32 *xs = 0;
+    i32 *ys = 0;
     u32 i;
 
-    if (!editor->mesh || editor->mesh->vertices_size < 6 || editor->mesh->indices_size < 2)
+    if (!editor->mesh || editor->mesh->vertices_size < 6 || editor->mesh->indices_size < 3)
     {
         return;
     }
 
-    for (i = 0; i + 1 < mesh->indices_size; i += 2)
+    /* Shared vertices are projected once instead of for every edge using them */
+    if (editor->projection && mesh->vertices_size / 3 <= editor->projection_capacity)
     {
-        u32 i0 = mesh->indices[i];
-        u32 i1 = mesh->indices[i + 1];
-
-        f32 x0 = mesh->vertices[i0 * 3 + 0];
-        f32 y0 = mesh->vertices[i0 * 3 + 1];
-        f32 z0 = mesh->vertices[i0 * 3 + 2];
+        xs = editor->projection + region_index * 2 * editor->projection_capacity;
+        ys = xs + editor->projection_capacity;
 
-        f32 x1 = mesh->vertices[i1 * 3 + 0];
-        f32 y1 = mesh->vertices[i1 * 3 + 1];
-        f32 z1 = mesh->vertices[i1 * 3 + 2];
-
-        u32 sx0, sy0, sx1, sy1;
+        lmtyn_editor_project_vertices(editor, region_index, mesh->vertices, mesh->vertices_size / 3, xs, ys);
+    }
 
-        /* Draw projections into each region */
-        /* XZ view */
-        lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XZ, x0, z0, &sx0, &sy0);
-        lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XZ, x1, z1, &sx1, &sy1);
-        lmtyn_editor_draw_line(editor, LMTYN_EDITOR_REGION_XZ, sx0, sy0, sx1, sy1, editor->mesh_color_wireframe);
+    if (mesh->edges && mesh->edges_size >= 2)
+    {
+        for (i = 0; i + 1 < mesh->edges_size; i += 2)
+        {
+            lmtyn_editor_draw_mesh_edge(editor, region_index, xs, ys, mesh->edges[i], mesh->edges[i + 1]);
+        }
 
-        /* YZ view */
-        lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_YZ, y0, z0, &sx0, &sy0);
-        lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_YZ, y1, z1, &sx1, &sy1);
-        lmtyn_editor_draw_line(editor, LMTYN_EDITOR_REGION_YZ, sx0, sy0, sx1, sy1, editor->mesh_color_wireframe);
+        return;
+    }
 
-        /* XY view */
-        lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XY, x0, y0, &sx0, &sy0);
-        lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XY, x1, y1, &sx1, &sy1);
-        lmtyn_editor_draw_line(editor, LMTYN_EDITOR_REGION_XY, sx0, sy0, sx1, sy1, editor->mesh_color_wireframe);
+    for (i = 0; i + 2 < mesh->indices_size; i += 3)
+    {
+        lmtyn_editor_draw_mesh_edge(editor, region_index, xs, ys, mesh->indices[i], mesh->indices[i + 1]);
+        lmtyn_editor_draw_mesh_edge(editor, region_index, xs, ys, mesh->indices[i + 1], mesh->indices[i + 2]);
+        lmtyn_editor_draw_mesh_edge(editor, region_index, xs, ys, mesh->indices[i + 2], mesh->indices[i]);
     }
 }
 
-LMTYN_API void lmtyn_editor_draw_circle_boxes(lmtyn_editor *editor)
+LMTYN_API void lmtyn_editor_draw_circle_boxes(lmtyn_editor *editor, u32 region_index)
 {
     u32 i;
 
@@ -1395,6 +3154,8 @@ LMTYN_API void lmtyn_editor_draw_circle_boxes(lmtyn_editor *editor)
         f32 vx1, vy1, vz1;
 
         i32 e;
+        i32 corners_x[8];
+        i32 corners_y[8];
 
         if (length < 1e-6f)
         {
@@ -1468,116 +3229,268 @@ LMTYN_API void lmtyn_editor_draw_circle_boxes(lmtyn_editor *editor)
             {3, 7} /* connections */
         };
 
+        /* Every corner is shared by three edges, project them once */
+        lmtyn_editor_project_vertices(editor, region_index, &corners[0][0], 8, corners_x, corners_y);
+
         for (e = 0; e < 12; ++e)
         {
             i32 a = edges[e][0];
             i32 b = edges[e][1];
-            u32 sx0, sy0, sx1, sy1;
 
-            lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XZ, corners[a][0], corners[a][2], &sx0, &sy0);
-            lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XZ, corners[b][0], corners[b][2], &sx1, &sy1);
-            lmtyn_editor_draw_line(editor, LMTYN_EDITOR_REGION_XZ, sx0, sy0, sx1, sy1, editor->mesh_color_wireframe);
+            lmtyn_editor_draw_line(editor, region_index, corners_x[a], corners_y[a], corners_x[b], corners_y[b], editor->mesh_color_wireframe);
+        }
+    }
+}
 
-            lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_YZ, corners[a][1], corners[a][2], &sx0, &sy0);
-            lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_YZ, corners[b][1], corners[b][2], &sx1, &sy1);
-            lmtyn_editor_draw_line(editor, LMTYN_EDITOR_REGION_YZ, sx0, sy0, sx1, sy1, editor->mesh_color_wireframe);
+/* Source column tables of the 3D view blit are built for this many destination columns at once */
+#define LMTYN_EDITOR_BLIT_COLUMNS 512
 
-            lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XY, corners[a][0], corners[a][1], &sx0, &sy0);
-            lmtyn_editor_world_to_screen(editor, LMTYN_EDITOR_REGION_XY, corners[b][0], corners[b][1], &sx1, &sy1);
-            lmtyn_editor_draw_line(editor, LMTYN_EDITOR_REGION_XY, sx0, sy0, sx1, sy1, editor->mesh_color_wireframe);
-        }
+/* Nearest row blit from the right so a row can be stretched in place */
+LMTYN_API void lmtyn_editor_blit_row_nearest(
+    u32 *dst,
+    u32 *src,
+    u32 *columns,
+    u32 count)
+{
+    u32 x = count;
+
+#ifdef LMTYN_EDITOR_USE_SSE2
+    while (x >= 4)
+    {
+        x -= 4;
+        _mm_storeu_si128(
+            (__m128i *)(void *)&dst[x],
+            _mm_set_epi32((i32)src[columns[x + 3]], (i32)src[columns[x + 2]], (i32)src[columns[x + 1]], (i32)src[columns[x]]));
+    }
+#endif
+
+    while (x-- > 0)
+    {
+        dst[x] = src[columns[x]];
     }
 }
-LMTYN_API void lmtyn_editor_draw_3d_framebuffer(lmtyn_editor *editor, csr_context *ctx)
+
+/* Bilinear row blit between the source rows top and bottom, weight_y is the weight of bottom (0..256).
+ * All sources of a group are read before it is stored, the sources of later groups are left of it.
+ */
+LMTYN_API void lmtyn_editor_blit_row_bilinear(
+    u32 *dst,
+    u32 *top,
+    u32 *bottom,
+    u32 *columns,
+    u32 *weights,
+    u32 count,
+    u32 weight_y,
+    u32 src_w)
 {
-    lmtyn_editor_region *r = &editor->regions[LMTYN_EDITOR_REGION_RENDER];
-    u32 *dst_row;
-    u32 dst_stride = editor->framebuffer_width;
-    u32 y;
+    u32 x = count;
+
+#ifdef LMTYN_EDITOR_USE_SSE2
+    __m128i zero = _mm_setzero_si128();
+    __m128i one = _mm_set1_epi16(256);
+    __m128i wy = _mm_set1_epi16((short)weight_y);
+    __m128i wy_inv = _mm_sub_epi16(one, wy);
 
-    /* Calculate Fixed Point Steps (16.16 format) */
-    u32 step_x = (ctx->width << 16) / r->w;
-    u32 step_y = (ctx->height << 16) / r->h;
+    while (x >= 4)
+    {
+        u32 c0, c1, c2, c3;
+        __m128i tl, tr, bl, br, wx, wx_inv, lo, hi;
+
+        x -= 4;
+        c0 = columns[x];
+        c1 = columns[x + 1];
+        c2 = columns[x + 2];
+        c3 = columns[x + 3];
+
+        tl = _mm_set_epi32((i32)top[c3], (i32)top[c2], (i32)top[c1], (i32)top[c0]);
+        bl = _mm_set_epi32((i32)bottom[c3], (i32)bottom[c2], (i32)bottom[c1], (i32)bottom[c0]);
+        c0 += c0 + 1 < src_w;
+        c1 += c1 + 1 < src_w;
+        c2 += c2 + 1 < src_w;
+        c3 += c3 + 1 < src_w;
+        tr = _mm_set_epi32((i32)top[c3], (i32)top[c2], (i32)top[c1], (i32)top[c0]);
+        br = _mm_set_epi32((i32)bottom[c3], (i32)bottom[c2], (i32)bottom[c1], (i32)bottom[c0]);
+
+        /* Pixels 0 and 1 as 16 bit channels, products stay below 65536 */
+        wx = _mm_set_epi16((short)weights[x + 1], (short)weights[x + 1], (short)weights[x + 1], (short)weights[x + 1],
+                           (short)weights[x], (short)weights[x], (short)weights[x], (short)weights[x]);
+        wx_inv = _mm_sub_epi16(one, wx);
+        lo = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(tl, zero), wx_inv), _mm_mullo_epi16(_mm_unpacklo_epi8(tr, zero), wx)), 8), wy_inv),
+            _mm_mullo_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(bl, zero), wx_inv), _mm_mullo_epi16(_mm_unpacklo_epi8(br, zero), wx)), 8), wy));
+
+        /* Pixels 2 and 3 */
+        wx = _mm_set_epi16((short)weights[x + 3], (short)weights[x + 3], (short)weights[x + 3], (short)weights[x + 3],
+                           (short)weights[x + 2], (short)weights[x + 2], (short)weights[x + 2], (short)weights[x + 2]);
+        wx_inv = _mm_sub_epi16(one, wx);
+        hi = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(tl, zero), wx_inv), _mm_mullo_epi16(_mm_unpackhi_epi8(tr, zero), wx)), 8), wy_inv),
+            _mm_mullo_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(bl, zero), wx_inv), _mm_mullo_epi16(_mm_unpackhi_epi8(br, zero), wx)), 8), wy));
+
+        _mm_storeu_si128((__m128i *)(void *)&dst[x], _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+#endif
 
-    u32 src_y_fixed = 0;
+    while (x-- > 0)
+    {
+        u32 c = columns[x];
+        u32 c_next = c + (c + 1 < src_w);
+        u32 t = lmtyn_editor_blend(top[c], top[c_next], weights[x]);
+        u32 b = lmtyn_editor_blend(bottom[c], bottom[c_next], weights[x]);
 
-    /* Pre-calculate start pointer */
-    dst_row = editor->framebuffer + (r->y * dst_stride) + r->x;
+        dst[x] = lmtyn_editor_blend(t, b, weight_y);
+    }
+}
 
-    for (y = 0; y < r->h; ++y)
+/* Stretches the src_w x src_h pixels in the top left corner of the render region over the whole region.
+ * Runs in place from the bottom right since every destination pixel is at or behind its source pixels.
+ * Source columns and filter weights are tabled once per block of columns and shared by all rows.
+ */
+LMTYN_API void lmtyn_editor_upscale_3d_model(
+    lmtyn_editor *editor,
+    u32 src_w,
+    u32 src_h)
+{
+    lmtyn_editor_region *r = &editor->regions[LMTYN_EDITOR_REGION_RENDER];
+    u32 *region = editor->framebuffer + r->y * editor->framebuffer_width + r->x;
+    u32 step_x = (src_w << 16) / r->w;
+    u32 step_y = (src_h << 16) / r->h;
+    u32 columns[LMTYN_EDITOR_BLIT_COLUMNS];
+    u32 weights[LMTYN_EDITOR_BLIT_COLUMNS];
+    u32 block_end = r->w;
+
+    while (block_end > 0)
     {
+        u32 block_start = block_end > LMTYN_EDITOR_BLIT_COLUMNS ? block_end - LMTYN_EDITOR_BLIT_COLUMNS : 0;
+        u32 count = block_end - block_start;
         u32 x;
-        u32 src_x_fixed = 0;
-        u32 fb_y = r->y + y;
-        u32 sy = src_y_fixed >> 16;
-        csr_color *src_row_ptr;
-
-        if (fb_y >= editor->framebuffer_height)
-        {
-            break;
-        }
+        u32 y = r->h;
 
-        if (sy >= ctx->height)
+        for (x = 0; x < count; ++x)
         {
-            sy = ctx->height - 1;
+            u32 source_x = (block_start + x) * step_x;
+            columns[x] = source_x >> 16;
+            weights[x] = (source_x >> 8) & 0xFF;
         }
 
-        src_row_ptr = &ctx->framebuffer[sy * ctx->width];
-
-        for (x = 0; x < r->w; ++x)
+        while (y-- > 0)
         {
-            u32 sx = src_x_fixed >> 16;
-            csr_color *src;
+            u32 source_y = y * step_y;
+            u32 *dst = region + y * editor->framebuffer_width + block_start;
+            u32 *top = region + (source_y >> 16) * editor->framebuffer_width;
 
-            if (sx >= ctx->width)
+            if (editor->render_scale_bilinear)
             {
-                sx = ctx->width - 1;
+                u32 *bottom = (source_y >> 16) + 1 < src_h ? top + editor->framebuffer_width : top;
+                lmtyn_editor_blit_row_bilinear(dst, top, bottom, columns, weights, count, (source_y >> 8) & 0xFF, src_w);
+            }
+            else
+            {
+                lmtyn_editor_blit_row_nearest(dst, top, columns, count);
             }
-
-            src = src_row_ptr + sx;
-            dst_row[x] = (src->r << 16) | (src->g << 8) | (src->b);
-            src_x_fixed += step_x;
         }
 
-        src_y_fixed += step_y;
-        dst_row += dst_stride;
+        block_end = block_start;
     }
 }
 
+/* Renders the mesh straight into the render region of the editor framebuffer.
+ * ctx only has to provide the zbuffer memory (csr_memory_size_xrgb) for the region size, its depth format is kept.
+ * If the memory has room for a visibility buffer (csr_visibility_buffer_size) behind it the 3D view supports picking.
+ * With render_scale_adaptive the mesh is rendered at render_scale while the user edits and upscaled to the region.
+ */
 LMTYN_API void lmtyn_editor_draw_3d_model(
     lmtyn_editor *editor,
     csr_context *ctx)
 {
+    lmtyn_editor_region *r = &editor->regions[LMTYN_EDITOR_REGION_RENDER];
     csr_color clear_color = {40, 40, 40};
     v3 cam_position = vm_v3(0.0f, 0.0f, 1.0f);
     v3 world_up = vm_v3(0.0f, 1.0f, 0.0f);
     v3 cam_look_at_pos = vm_v3(0.0f, 0.0f, 0.0f);
     f32 cam_fov = 90.0f;
-    v3 model_position = vm_v3_zero;
+    f32 model_center[3];
+    f32 model_size;
+    f32 model_scale;
+    f32 scale = (editor->render_scale_adaptive && editor->render_interactive) ? editor->render_scale : 1.0f;
+    u32 render_w = (u32)((f32)r->w * scale);
+    u32 render_h = (u32)((f32)r->h * scale);
+    double render_start;
+
+    m4x4 projection;
+    m4x4 view;
+    m4x4 projection_view;
+    m4x4 model_base;
+    m4x4 model_view_projection;
+
+    if (editor->circles_count < 2 || r->w < 1 || r->h < 1 ||
+        !lmtyn_mesh_bounds(editor->mesh, model_center, &model_size))
+    {
+        return;
+    }
 
-    m4x4 projection = vm_m4x4_perspective(vm_radf(cam_fov), (f32)ctx->width / (f32)ctx->height, 0.1f, 1000.0f);
-    m4x4 view = vm_m4x4_lookAt(cam_position, cam_look_at_pos, world_up);
-    m4x4 projection_view = vm_m4x4_mul(projection, view);
-    m4x4 model_base = vm_m4x4_translate(vm_m4x4_identity, model_position);
-    m4x4 model_view_projection = vm_m4x4_mul(projection_view, model_base);
+    render_w = render_w < 1 ? 1 : (render_w > r->w ? r->w : render_w);
+    render_h = render_h < 1 ? 1 : (render_h > r->h ? r->h : render_h);
+    render_start = perf_platform_current_time_nanoseconds();
 
-    if (editor->circles_count < 2)
+    /* Bind the CSR context to the render region, no intermediate color buffer and copy needed */
+    if (!csr_init_model_xrgb(
+            ctx, ctx->memory, ctx->memory_size,
+            editor->framebuffer + r->y * editor->framebuffer_width + r->x,
+            (i32)editor->framebuffer_width,
+            (i32)render_w, (i32)render_h, ctx->depth_format))
     {
         return;
     }
 
-    /* Draw Mesh to CSR Framebuffer */
-    csr_render_clear_screen(ctx, clear_color);
+    {
+        unsigned long used = (csr_memory_size_xrgb(ctx->width, ctx->height, ctx->depth_format) + 3) & ~3UL;
+
+        if (ctx->memory_size > used)
+        {
+            csr_visibility_buffer_init(ctx, (u8 *)ctx->memory + used, ctx->memory_size - used);
+        }
+    }
+
+    projection = vm_m4x4_perspective(vm_radf(cam_fov), (f32)ctx->width / (f32)ctx->height, 0.1f, 1000.0f);
+    view = vm_m4x4_lookAt(cam_position, cam_look_at_pos, world_up);
+    projection_view = vm_m4x4_mul(projection, view);
+    /* Fits the mesh into the unit cube at the origin, the 2D views keep drawing the mesh in world space */
+    model_scale = 1.0f / model_size;
+    model_base = vm_m4x4_translate(
+        vm_m4x4_scalef(vm_m4x4_identity, model_scale),
+        vm_v3(-model_center[0] * model_scale, -model_center[1] * model_scale, -model_center[2] * model_scale));
+    model_view_projection = vm_m4x4_mul(projection_view, model_base);
+
+    /* Draw Mesh lit by the default light to the render region, tiles the mesh does not cover only get the clear color */
+    csr_render_clear_screen_deferred(ctx, clear_color);
+    ctx->draw_id = 0;
     csr_render(
         ctx,
-        CSR_RENDER_SOLID,
+        CSR_RENDER_LIT,
         CSR_CULLING_CCW_BACKFACE, 3,
         editor->mesh->vertices, editor->mesh->vertices_size,
         (i32 *)editor->mesh->indices, editor->mesh->indices_size,
         model_view_projection.e);
+    csr_render_resolve(ctx);
 
-    /* Draw CSR Framebuffer to Editor Framebuffer */
-    lmtyn_editor_draw_3d_framebuffer(editor, ctx);
+    if (render_w != r->w || render_h != r->h)
+    {
+        lmtyn_editor_upscale_3d_model(editor, render_w, render_h);
+    }
+
+    editor->render_time_ms = (f32)((perf_platform_current_time_nanoseconds() - render_start) / 1000000.0);
+
+    /* Render time grows with the pixel count, pick the scale whose area fits into the budget and move half way there */
+    if (editor->render_scale_adaptive && editor->render_time_ms > 0.0f)
+    {
+        f32 rendered_area = ((f32)render_w * (f32)render_h) / ((f32)r->w * (f32)r->h);
+        f32 target = csr_sqrtf(editor->render_budget_ms * rendered_area / editor->render_time_ms);
+
+        editor->render_scale = 0.5f * (editor->render_scale + target);
+        editor->render_scale = editor->render_scale < editor->render_scale_min ? editor->render_scale_min : editor->render_scale;
+        editor->render_scale = editor->render_scale > 1.0f ? 1.0f : editor->render_scale;
+    }
 }
 
 LMTYN_API void lmtyn_editor_regions_update(lmtyn_editor *editor)
@@ -1705,19 +3618,103 @@ LMTYN_API u8 lmtyn_editor_initialize(
     editor->wireframe_mode = LMTYN_EDITOR_WIREFRAME_MESH_WIREFRAME;
 
     editor->mesh = mesh;
+    editor->mesh_segments = 4;
     editor->mesh_color_wireframe = 0x00666666;
 
-    editor->circles = circles;
-    editor->circles_capacity = circles_capacity;
-    editor->circles_color = 0x00FFCE1B;
-    editor->circles_color_line = 0x00C59B00; /* 30 perc. darkened */
-    editor->circles_color_selected = 0x00FF0000;
-    editor->circles_last_radius = 1.0f;
+    editor->render_scale_adaptive = 0;
+    editor->render_scale = 1.0f;
+    editor->render_scale_min = 0.25f;
+    editor->render_budget_ms = 8.0f;
+    editor->render_scale_bilinear = 1;
+
+    editor->jobs_run = 0;
+    editor->jobs_context = 0;
+
+    editor->mesh_worker = 0;
+    editor->mesh_generation = 0;
+
+    lmtyn_editor_draw_lists_init(editor, 0, 0);
+
+    editor->grid_cache = 0;
+    editor->grid_cache_size = 0;
+
+    editor->projection = 0;
+    editor->projection_capacity = 0;
+
+    editor->circles = circles;
+    editor->circles_capacity = circles_capacity;
+    editor->circles_color = 0x00FFCE1B;
+    editor->circles_color_line = 0x00C59B00; /* 30 perc. darkened */
+    editor->circles_color_selected = 0x00FF0000;
+    editor->circles_color_hovered = 0x00FFFFFF;
+    editor->circles_hovered_circle_index = LMTYN_EDITOR_CIRCLE_NONE;
+    editor->circles_dragging = 0;
+    editor->circles_last_radius = 1.0f;
+    editor->circles_bounds = 0;
+    editor->circles_bounds_blocks = 0;
+    editor->circles_bounds_count = 0;
+    editor->circles_grid = 0;
+
+    editor->font_glyph_width = LMTYN_EDITOR_FONT_GLYPH_WIDTH;
+    editor->font_glyph_height = LMTYN_EDITOR_FONT_GLYPH_HEIGHT;
+    lmtyn_editor_font_cache_update(editor);
+
+    lmtyn_editor_regions_update(editor);
+
+    return 1;
+}
+
+/* Memory needed by lmtyn_editor_projection_init for meshes of up to vertices_count vertices */
+LMTYN_API unsigned long lmtyn_editor_projection_size(u32 vertices_count)
+{
+    /* x and y array per 2D view */
+    return (unsigned long)vertices_count * 2 * LMTYN_EDITOR_REGION_RENDER * sizeof(i32);
+}
+
+/* Attaches the memory of the projected mesh vertices, larger meshes are projected per edge */
+LMTYN_API u8 lmtyn_editor_projection_init(lmtyn_editor *editor, void *memory, unsigned long memory_size)
+{
+    editor->projection = 0;
+    editor->projection_capacity = 0;
+
+    if (!memory || memory_size < lmtyn_editor_projection_size(1))
+    {
+        return 0;
+    }
+
+    editor->projection = (i32 *)memory;
+    editor->projection_capacity = (u32)(memory_size / lmtyn_editor_projection_size(1));
+
+    return 1;
+}
+
+/* Memory needed by lmtyn_editor_grid_cache_init for a framebuffer of this size */
+LMTYN_API unsigned long lmtyn_editor_grid_cache_size(u32 framebuffer_width, u32 framebuffer_height)
+{
+    return (unsigned long)framebuffer_width * framebuffer_height * sizeof(u32);
+}
+
+/* Attaches the cached grid layer, has to be called again after the framebuffer was resized.
+ * Returns 0 if the memory is too small, the grid is drawn every frame then.
+ */
+LMTYN_API u8 lmtyn_editor_grid_cache_init(lmtyn_editor *editor, void *memory, unsigned long memory_size)
+{
+    u32 i;
+
+    for (i = 0; i < LMTYN_EDITOR_REGION_COUNT; ++i)
+    {
+        editor->regions[i].grid_cached = 0;
+    }
 
-    editor->font_glyph_width = LMTYN_EDITOR_FONT_GLYPH_WIDTH;
-    editor->font_glyph_height = LMTYN_EDITOR_FONT_GLYPH_HEIGHT;
+    if (!memory || memory_size < lmtyn_editor_grid_cache_size(editor->framebuffer_width, editor->framebuffer_height))
+    {
+        editor->grid_cache = 0;
+        editor->grid_cache_size = 0;
+        return 0;
+    }
 
-    lmtyn_editor_regions_update(editor);
+    editor->grid_cache = (u32 *)memory;
+    editor->grid_cache_size = memory_size;
 
     return 1;
 }
@@ -1758,6 +3755,9 @@ LMTYN_API void lmtyn_editor_input_keys_update(lmtyn_editor_input *in)
 
 static u8 initialized;
 
+/* Circles are picked in the 2D views when their center is at most this many pixels away from the mouse */
+#define LMTYN_EDITOR_PICK_DISTANCE 10.0f
+
 LMTYN_API void lmtyn_editor_input_update(
     lmtyn_editor *editor,
     lmtyn_editor_input *input)
@@ -1794,6 +3794,7 @@ LMTYN_API void lmtyn_editor_input_update(
         if (input->key_z.pressed && editor->circles_count > 0)
         {
             editor->circles_count--;
+            lmtyn_editor_circle_index_update_circle(editor, editor->circles_count);
         }
 
         lmtyn_editor_regions_update(editor);
@@ -1870,6 +3871,8 @@ LMTYN_API void lmtyn_editor_input_update(
                 editor->regions[i].grid_scroll_offset_x = 0.0f;
                 editor->regions[i].grid_scroll_offset_y = 0.0f;
             }
+
+            lmtyn_editor_circle_index_update(editor);
         }
     }
 
@@ -1897,6 +3900,7 @@ LMTYN_API void lmtyn_editor_input_update(
         {
             editor->circles_count++;
             editor->circles_selected_circle_index = editor->circles_count - 1;
+            lmtyn_editor_circle_index_update_circle(editor, editor->circles_count - 1);
             initialized = 1;
         }
 
@@ -1907,6 +3911,7 @@ LMTYN_API void lmtyn_editor_input_update(
                 editor->circles_count > 0)
             {
                 editor->circles_count--;
+                lmtyn_editor_circle_index_update_circle(editor, editor->circles_count);
             }
 
             editor->selection_mode = LMTYN_EDITOR_MODE_CIRCLE_SELECTION;
@@ -1970,6 +3975,8 @@ LMTYN_API void lmtyn_editor_input_update(
                 circle->radius = lmtyn_clampf(circle->radius, 0.1f, 10.0f);
             }
 
+            lmtyn_editor_circle_index_update_circle(editor, current_circle_index);
+
             if (input->mouse_left.pressed)
             {
                 editor->circles_last_x = circle->center_x;
@@ -1982,11 +3989,81 @@ LMTYN_API void lmtyn_editor_input_update(
                 editor->circles[editor->circles_count - 1].center_y = editor->circles_last_y;
                 editor->circles[editor->circles_count - 1].center_z = editor->circles_last_z;
                 editor->circles[editor->circles_count - 1].radius = circle->radius;
+                lmtyn_editor_circle_index_update_circle(editor, editor->circles_count - 1);
+            }
+        }
+    }
+
+    /* Pick and drag existing circles */
+    editor->circles_hovered_circle_index = LMTYN_EDITOR_CIRCLE_NONE;
+
+    if (editor->selection_mode == LMTYN_EDITOR_MODE_CIRCLE_SELECTION && lmtyn_editor_is_drawing_region(editor))
+    {
+        u32 region_index = (u32)editor->regions_selected_region_index;
+
+        if (!input->mouse_left.down)
+        {
+            editor->circles_dragging = 0;
+        }
+
+        if (editor->circles_dragging && editor->circles_selected_circle_index < editor->circles_count)
+        {
+            lmtyn_shape_circle *circle = &editor->circles[editor->circles_selected_circle_index];
+
+            f32 wx, wy;
+            lmtyn_editor_screen_to_world(editor, region_index, input->mouse_x, input->mouse_y, &wx, &wy);
+
+            if (editor->snap_enabled)
+            {
+                wx = lmtyn_snap(wx, editor->snap_interval);
+                wy = lmtyn_snap(wy, editor->snap_interval);
+            }
+
+            /* The axis not shown by the view keeps its value */
+            if (region_index == LMTYN_EDITOR_REGION_YZ)
+            {
+                circle->center_y = wx;
+            }
+            else
+            {
+                circle->center_x = wx;
+            }
+
+            if (region_index == LMTYN_EDITOR_REGION_XY)
+            {
+                circle->center_y = wy;
+            }
+            else
+            {
+                circle->center_z = wy;
+            }
+
+            lmtyn_editor_circle_index_update_circle(editor, editor->circles_selected_circle_index);
+
+            editor->circles_hovered_circle_index = editor->circles_selected_circle_index;
+        }
+        else
+        {
+            editor->circles_dragging = 0;
+            editor->circles_hovered_circle_index = lmtyn_editor_circles_nearest(
+                editor, region_index,
+                (f32)input->mouse_x, (f32)input->mouse_y,
+                LMTYN_EDITOR_PICK_DISTANCE);
+
+            if (input->mouse_left.pressed && editor->circles_hovered_circle_index != LMTYN_EDITOR_CIRCLE_NONE)
+            {
+                editor->circles_selected_circle_index = editor->circles_hovered_circle_index;
+                editor->circles_dragging = 1;
             }
         }
     }
+    else
+    {
+        editor->circles_dragging = 0;
+    }
 
-    if (input->mouse_left.pressed && lmtyn_editor_is_drawing_region(editor))
+    /* Clicking next to the circles continues placing new ones */
+    if (input->mouse_left.pressed && lmtyn_editor_is_drawing_region(editor) && !editor->circles_dragging)
     {
         editor->selection_mode = LMTYN_EDITOR_MODE_CIRCLE_PLACEMENT;
     }
@@ -2014,7 +4091,11 @@ LMTYN_API void lmtyn_editor_ui_update(
         input->mouse_left.pressed);
 
     editor->snap_enabled = snap_button.active;
-    lmtyn_editor_ui_draw_button(editor, toolbar, &snap_button);
+
+    if (toolbar->dirty)
+    {
+        lmtyn_editor_ui_draw_button(editor, toolbar, &snap_button);
+    }
 
     lmtyn_editor_ui_slider radius_slider = {
         {40, 5, 100, 20, 0, 0x00202020, 0x00FFCE1B, 0x00505050, 0x00FFCE1B},
@@ -2027,56 +4108,478 @@ LMTYN_API void lmtyn_editor_ui_update(
         input->mouse_x, input->mouse_y,
         input->mouse_left.down);
 
-    editor->circles[editor->circles_selected_circle_index].radius = radius_slider.slider_val;
+    if (editor->circles[editor->circles_selected_circle_index].radius != radius_slider.slider_val)
+    {
+        editor->circles[editor->circles_selected_circle_index].radius = radius_slider.slider_val;
+        lmtyn_editor_circle_index_update_circle(editor, editor->circles_selected_circle_index);
+    }
+
     editor->circles_last_radius = radius_slider.slider_val;
 
-    lmtyn_editor_ui_draw_slider(editor, toolbar, &radius_slider);
+    if (toolbar->dirty)
+    {
+        lmtyn_editor_ui_draw_slider(editor, toolbar, &radius_slider);
+    }
+}
+
+/* #############################################################################
+ * # [SECTION] Dirty Regions
+ * #############################################################################
+ */
+LMTYN_API LMTYN_INLINE u32 lmtyn_editor_hash(u32 hash, void *data, u32 size)
+{
+    u8 *bytes = (u8 *)data;
+    u32 i;
+
+    /* FNV-1a */
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+LMTYN_API LMTYN_INLINE u32 lmtyn_editor_hash_u32(u32 hash, u32 value)
+{
+    return lmtyn_editor_hash(hash, &value, sizeof(value));
+}
+
+LMTYN_API LMTYN_INLINE u32 lmtyn_editor_hash_f32(u32 hash, f32 value)
+{
+    return lmtyn_editor_hash(hash, &value, sizeof(value));
+}
+
+/* Hashes every input of the drawing of each region and marks the regions whose hash changed as dirty.
+ * force redraws everything, e.g. after the framebuffer was reallocated.
+ */
+LMTYN_API void lmtyn_editor_regions_update_dirty(
+    lmtyn_editor *editor,
+    lmtyn_editor_input *input,
+    u8 force)
+{
+    u32 model = 2166136261U;
+    u32 i;
+
+    /* Circles and mesh settings shared by the three views and the 3D view */
+    model = lmtyn_editor_hash_u32(model, editor->circles_count);
+    model = lmtyn_editor_hash(model, editor->circles, editor->circles_count * (u32)sizeof(lmtyn_shape_circle));
+    model = lmtyn_editor_hash_u32(model, editor->circles_selected_circle_index);
+    model = lmtyn_editor_hash_u32(model, editor->mesh_segments);
+    model = lmtyn_editor_hash_u32(model, editor->mesh_generation);
+
+    editor->dirty_rects_count = 0;
+
+    for (i = 0; i < LMTYN_EDITOR_REGION_COUNT; ++i)
+    {
+        lmtyn_editor_region *r = &editor->regions[i];
+        u32 signature = 2166136261U;
+
+        /* Layout and border of the region */
+        signature = lmtyn_editor_hash(signature, &editor->framebuffer, (u32)sizeof(editor->framebuffer));
+        signature = lmtyn_editor_hash_u32(signature, editor->framebuffer_width);
+        signature = lmtyn_editor_hash_u32(signature, r->x);
+        signature = lmtyn_editor_hash_u32(signature, r->y);
+        signature = lmtyn_editor_hash_u32(signature, r->w);
+        signature = lmtyn_editor_hash_u32(signature, r->h);
+        signature = lmtyn_editor_hash_u32(signature, r->color_background);
+        signature = lmtyn_editor_hash_u32(signature, editor->regions_selected_region_index == (i32)i ? 1U + (u32)editor->selection_mode : 0U);
+
+        if (i == LMTYN_EDITOR_REGION_XZ || i == LMTYN_EDITOR_REGION_YZ || i == LMTYN_EDITOR_REGION_XY)
+        {
+            signature = lmtyn_editor_hash_u32(signature, model);
+            signature = lmtyn_editor_hash_u32(signature, editor->circles_hovered_circle_index);
+            signature = lmtyn_editor_hash_u32(signature, (u32)editor->wireframe_mode);
+            signature = lmtyn_editor_hash_f32(signature, r->grid_scroll_offset_x);
+            signature = lmtyn_editor_hash_f32(signature, r->grid_scroll_offset_y);
+            signature = lmtyn_editor_hash_f32(signature, editor->grid_scale);
+            signature = lmtyn_editor_hash_f32(signature, editor->grid_cell_size);
+        }
+        else if (i == LMTYN_EDITOR_REGION_RENDER)
+        {
+            /* Leaving the interactive mode renders the reduced resolution view again at full resolution */
+            signature = lmtyn_editor_hash_u32(signature, model);
+            signature = lmtyn_editor_hash_u32(signature, editor->render_scale_adaptive && editor->render_interactive);
+            signature = lmtyn_editor_hash_u32(signature, editor->render_scale_bilinear);
+        }
+        else if (i == LMTYN_EDITOR_REGION_TOOLBAR)
+        {
+            /* Hover only matters while the mouse is over the toolbar */
+            u8 hover = input->mouse_x >= r->x && input->mouse_x < r->x + r->w &&
+                       input->mouse_y >= r->y && input->mouse_y < r->y + r->h;
+
+            signature = lmtyn_editor_hash_u32(signature, hover ? input->mouse_x : 0xFFFFFFFFU);
+            signature = lmtyn_editor_hash_u32(signature, hover ? input->mouse_y : 0xFFFFFFFFU);
+            signature = lmtyn_editor_hash_u32(signature, input->mouse_left.down);
+            signature = lmtyn_editor_hash_u32(signature, editor->snap_enabled);
+            signature = lmtyn_editor_hash_f32(signature, editor->circles[editor->circles_selected_circle_index].radius);
+        }
+
+        r->dirty = (u8)(force || signature != r->signature);
+        r->signature = signature;
+
+        if (r->dirty && r->w > 0 && r->h > 0)
+        {
+            lmtyn_editor_rect *rect = &editor->dirty_rects[editor->dirty_rects_count++];
+            rect->x = r->x;
+            rect->y = r->y;
+            rect->w = r->w;
+            rect->h = r->h;
+        }
+    }
+}
+
+/* #############################################################################
+ * # [SECTION] Mesh Worker
+ * #############################################################################
+ */
+
+/* Memory needed by lmtyn_editor_mesh_worker_init: the worker, its circle snapshots and a second mesh
+ * with the capacities of the mesh of the editor
+ */
+LMTYN_API unsigned long lmtyn_editor_mesh_worker_size(lmtyn_editor *editor)
+{
+    unsigned long size = (sizeof(lmtyn_editor_mesh_worker) + 7) & ~7UL;
+
+    size += (unsigned long)LMTYN_EDITOR_MESH_QUEUE_SIZE * editor->circles_capacity * sizeof(lmtyn_shape_circle);
+    size += (unsigned long)editor->mesh->vertices_capacity * sizeof(f32);
+    size += (unsigned long)editor->mesh->indices_capacity * sizeof(u32);
+    size += editor->mesh->edges ? (unsigned long)editor->mesh->edges_capacity * sizeof(u32) : 0;
+
+    return size;
+}
+
+/* Attaches a mesh worker, returns 0 if the memory is too small and the editor keeps generating the mesh itself.
+ * The host sets wake and wake_context afterwards and calls lmtyn_editor_mesh_worker_process on its own thread.
+ * The editor keeps drawing the last completed mesh until the worker finished the next one.
+ */
+LMTYN_API u8 lmtyn_editor_mesh_worker_init(lmtyn_editor *editor, void *memory, unsigned long memory_size)
+{
+    lmtyn_editor_mesh_worker *worker = (lmtyn_editor_mesh_worker *)memory;
+    u8 *data = (u8 *)memory + ((sizeof(lmtyn_editor_mesh_worker) + 7) & ~7UL);
+    u32 i;
+
+    editor->mesh_worker = 0;
+
+    if (!memory || memory_size < lmtyn_editor_mesh_worker_size(editor))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < LMTYN_EDITOR_MESH_QUEUE_SIZE; ++i)
+    {
+        worker->snapshots[i].circles = (lmtyn_shape_circle *)data;
+        worker->snapshots[i].circles_count = 0;
+        worker->snapshots[i].mesh_segments = 0;
+        data += editor->circles_capacity * sizeof(lmtyn_shape_circle);
+    }
+
+    worker->mesh.vertices_capacity = editor->mesh->vertices_capacity;
+    worker->mesh.indices_capacity = editor->mesh->indices_capacity;
+    worker->mesh.edges_capacity = editor->mesh->edges ? editor->mesh->edges_capacity : 0;
+    worker->mesh.vertices_size = 0;
+    worker->mesh.indices_size = 0;
+    worker->mesh.edges_size = 0;
+    worker->mesh.vertices = (f32 *)data;
+    data += editor->mesh->vertices_capacity * sizeof(f32);
+    worker->mesh.indices = (u32 *)data;
+    data += editor->mesh->indices_capacity * sizeof(u32);
+    worker->mesh.edges = editor->mesh->edges ? (u32 *)data : 0;
+
+    worker->snapshots_write = 0;
+    worker->snapshots_read = 0;
+    worker->mesh_ready = 0;
+    worker->model = 0;
+    worker->wake = 0;
+    worker->wake_context = 0;
+
+    editor->mesh_worker = worker;
+
+    return 1;
+}
+
+/* Runs on the platform thread. Generates the mesh of the newest posted snapshot into the back buffer,
+ * older snapshots are skipped. Returns 0 if there was nothing to do or the editor did not take the last mesh yet.
+ */
+LMTYN_API u8 lmtyn_editor_mesh_worker_process(lmtyn_editor_mesh_worker *worker)
+{
+    /* The snapshot was written before snapshots_write, the editor is done with the back buffer once mesh_ready is 0 */
+    u32 mesh_ready = LMTYN_EDITOR_LOAD_ACQUIRE(&worker->mesh_ready);
+    u32 write = LMTYN_EDITOR_LOAD_ACQUIRE(&worker->snapshots_write);
+    lmtyn_editor_mesh_snapshot *snapshot;
+
+    if (mesh_ready || write == worker->snapshots_read)
+    {
+        return 0;
+    }
+
+    snapshot = &worker->snapshots[(write - 1) & (LMTYN_EDITOR_MESH_QUEUE_SIZE - 1)];
+
+    worker->mesh.vertices_size = 0;
+    worker->mesh.indices_size = 0;
+
+    lmtyn_mesh_generate(&worker->mesh, 0, snapshot->circles, snapshot->circles_count, snapshot->mesh_segments);
+
+    /* The slots are free and the mesh complete before the editor sees the stores */
+    LMTYN_EDITOR_STORE_RELEASE(&worker->snapshots_read, write);
+    LMTYN_EDITOR_STORE_RELEASE(&worker->mesh_ready, 1U);
+
+    return 1;
+}
+
+/* Hash of the circles and segments a mesh is generated from */
+LMTYN_API u32 lmtyn_editor_mesh_worker_model(lmtyn_editor *editor)
+{
+    u32 circles_count = editor->circles_count < editor->circles_capacity ? editor->circles_count : editor->circles_capacity;
+    u32 model = 2166136261U;
+
+    model = lmtyn_editor_hash_u32(model, circles_count);
+    model = lmtyn_editor_hash(model, editor->circles, circles_count * (u32)sizeof(lmtyn_shape_circle));
+    model = lmtyn_editor_hash_u32(model, editor->mesh_segments);
+
+    return model;
+}
+
+/* Returns 1 if the mesh of the editor is not yet the mesh of the current circles */
+LMTYN_API u8 lmtyn_editor_mesh_worker_pending(lmtyn_editor *editor)
+{
+    lmtyn_editor_mesh_worker *worker = editor->mesh_worker;
+
+    return LMTYN_EDITOR_LOAD_ACQUIRE(&worker->mesh_ready) ||
+           LMTYN_EDITOR_LOAD_ACQUIRE(&worker->snapshots_read) != worker->snapshots_write ||
+           lmtyn_editor_mesh_worker_model(editor) != worker->model;
+}
+
+/* Takes a completed mesh from the worker and posts the circles if they changed since the last post.
+ * A full queue is retried on the next frame.
+ */
+LMTYN_API void lmtyn_editor_mesh_worker_update(lmtyn_editor *editor)
+{
+    lmtyn_editor_mesh_worker *worker = editor->mesh_worker;
+    u32 circles_count = editor->circles_count < editor->circles_capacity ? editor->circles_count : editor->circles_capacity;
+    u32 model = lmtyn_editor_mesh_worker_model(editor);
+    u8 wake = 0;
+
+    if (LMTYN_EDITOR_LOAD_ACQUIRE(&worker->mesh_ready))
+    {
+        lmtyn_mesh front = *editor->mesh;
+
+        *editor->mesh = worker->mesh;
+        worker->mesh = front;
+        editor->mesh_generation++;
+
+        /* The worker may only write the back buffer again after the swap */
+        LMTYN_EDITOR_STORE_RELEASE(&worker->mesh_ready, 0U);
+        wake = 1;
+    }
+
+    /* The worker released the slots before snapshots_read */
+    if (model != worker->model && worker->snapshots_write - LMTYN_EDITOR_LOAD_ACQUIRE(&worker->snapshots_read) < LMTYN_EDITOR_MESH_QUEUE_SIZE)
+    {
+        u32 write = worker->snapshots_write;
+        lmtyn_editor_mesh_snapshot *snapshot = &worker->snapshots[write & (LMTYN_EDITOR_MESH_QUEUE_SIZE - 1)];
+        u8 *src = (u8 *)editor->circles;
+        u8 *dst = (u8 *)snapshot->circles;
+        u32 size = circles_count * (u32)sizeof(lmtyn_shape_circle);
+        u32 i;
+
+        for (i = 0; i < size; ++i)
+        {
+            dst[i] = src[i];
+        }
+
+        snapshot->circles_count = circles_count;
+        snapshot->mesh_segments = editor->mesh_segments;
+
+        LMTYN_EDITOR_STORE_RELEASE(&worker->snapshots_write, write + 1);
+        worker->model = model;
+        wake = 1;
+    }
+
+    if (wake && worker->wake)
+    {
+        worker->wake(worker->wake_context);
+    }
+}
+
+/* Selects the circle under the mouse in the 3D view, a single read of the visibility buffer of the last render */
+LMTYN_API void lmtyn_editor_pick_3d_model(
+    lmtyn_editor *editor,
+    lmtyn_editor_input *input,
+    csr_context *ctx)
+{
+    lmtyn_editor_region *r = &editor->regions[LMTYN_EDITOR_REGION_RENDER];
+    u32 primitive_id;
+    u32 circle, segment;
+
+    if (!input->mouse_left.pressed || editor->regions_selected_region_index != LMTYN_EDITOR_REGION_RENDER)
+    {
+        return;
+    }
+
+    /* The triangles of a mesh still generated from older circles would map to the wrong circle */
+    if (editor->mesh_worker && lmtyn_editor_mesh_worker_pending(editor))
+    {
+        return;
+    }
+
+    /* The context may have been rendered below the region size, see render_scale */
+    primitive_id = csr_visibility_buffer_pick(
+        ctx,
+        ((i32)input->mouse_x - (i32)r->x) * ctx->width / (i32)r->w,
+        ((i32)input->mouse_y - (i32)r->y) * ctx->height / (i32)r->h);
+
+    if (primitive_id != CSR_PRIMITIVE_ID_NONE &&
+        lmtyn_mesh_triangle_source(editor->circles, editor->circles_count, editor->mesh_segments, csr_primitive_id_primitive(primitive_id), &circle, &segment))
+    {
+        editor->circles_selected_circle_index = circle;
+    }
 }
 
 /* #############################################################################
  * # [SECTION] Main Renderer
  * #############################################################################
  */
+typedef struct lmtyn_editor_view_job
+{
+    lmtyn_editor *editor;
+    csr_context *ctx;
+    u32 region_index;
+
+} lmtyn_editor_view_job;
+
+/* Draws one of the XZ, YZ, XY or 3D views, only touches the pixels of its own region */
+LMTYN_API void lmtyn_editor_draw_view(
+    lmtyn_editor *editor,
+    u32 region_index,
+    csr_context *ctx)
+{
+    if (region_index == LMTYN_EDITOR_REGION_RENDER)
+    {
+        lmtyn_editor_draw_background(editor, region_index, editor->framebuffer);
+        lmtyn_editor_draw_region_label(editor, region_index);
+        lmtyn_editor_draw_3d_model(editor, ctx);
+        return;
+    }
+
+    lmtyn_editor_draw_grid_layer(editor, region_index);
+
+    /* With draw lists the rest is drawn tile by tile by lmtyn_editor_draw_lists_execute */
+    lmtyn_editor_draw_list_begin(editor, region_index);
+
+    lmtyn_editor_draw_region_label(editor, region_index);
+
+    if (editor->wireframe_mode == LMTYN_EDITOR_WIREFRAME_CIRCLE_BOXES)
+    {
+        lmtyn_editor_draw_circle_boxes(editor, region_index);
+    }
+    else if (editor->wireframe_mode == LMTYN_EDITOR_WIREFRAME_MESH_WIREFRAME)
+    {
+        lmtyn_editor_draw_mesh_wireframe(editor, region_index);
+    }
+
+    lmtyn_editor_draw_circles(editor, region_index);
+}
+
+LMTYN_API void lmtyn_editor_draw_view_job(void *job_data)
+{
+    lmtyn_editor_view_job *job = (lmtyn_editor_view_job *)job_data;
+    lmtyn_editor_draw_view(job->editor, job->region_index, job->ctx);
+}
+
+/* Redraws the regions whose inputs changed since the last call, see dirty_rects for what the host has to present */
 LMTYN_API void lmtyn_editor_render(
     lmtyn_editor *editor,
     lmtyn_editor_input *input,
     csr_context *ctx)
 {
+    lmtyn_editor_region *regions = editor->regions;
+    u8 framebuffer_changed = input->framebuffer_size_changed;
+    lmtyn_editor_view_job jobs[LMTYN_EDITOR_REGION_RENDER + 1];
+    void *job_data[LMTYN_EDITOR_REGION_RENDER + 1];
+    u32 jobs_count = 0;
+    u32 i;
+
     lmtyn_editor_input_update(editor, input);
 
-    lmtyn_editor_draw_background(editor, LMTYN_EDITOR_REGION_XZ);
-    lmtyn_editor_draw_background(editor, LMTYN_EDITOR_REGION_YZ);
-    lmtyn_editor_draw_background(editor, LMTYN_EDITOR_REGION_XY);
-    lmtyn_editor_draw_background(editor, LMTYN_EDITOR_REGION_RENDER);
-    lmtyn_editor_draw_background(editor, LMTYN_EDITOR_REGION_MENU);
-    lmtyn_editor_draw_background(editor, LMTYN_EDITOR_REGION_TOOLBAR);
+    /* The views draw their labels from the scaled glyphs, possibly in parallel */
+    lmtyn_editor_font_cache_update(editor);
+
+    /* Picks from the visibility buffer of the last 3D view render, before the selection is hashed */
+    lmtyn_editor_pick_3d_model(editor, input, ctx);
+
+    /* Dragging and held keys edit the model, the 3D view may trade resolution for frame time meanwhile */
+    editor->render_interactive = (u8)(input->mouse_left.down || input->mouse_right.down ||
+                                      input->key_left.down || input->key_right.down || input->key_up.down || input->key_down.down);
 
-    lmtyn_editor_draw_grid(editor, LMTYN_EDITOR_REGION_XZ);
-    lmtyn_editor_draw_grid(editor, LMTYN_EDITOR_REGION_YZ);
-    lmtyn_editor_draw_grid(editor, LMTYN_EDITOR_REGION_XY);
-    lmtyn_editor_draw_region_labels(editor);
+    /* A newly swapped in mesh marks the views showing it dirty */
+    if (editor->mesh_worker)
+    {
+        lmtyn_editor_mesh_worker_update(editor);
+    }
 
-    /* Reset Mesh vertices/indices */
-    editor->mesh->vertices_size = 0;
-    editor->mesh->indices_size = 0;
+    lmtyn_editor_regions_update_dirty(editor, input, framebuffer_changed);
 
-    /* Generate Mesh */
-    lmtyn_mesh_generate(editor->mesh, 0, editor->circles, editor->circles_count, 4);
+    /* The mesh only has to be rebuilt for the views showing it, the views only read it */
+    if (!editor->mesh_worker &&
+        (regions[LMTYN_EDITOR_REGION_XZ].dirty || regions[LMTYN_EDITOR_REGION_YZ].dirty ||
+         regions[LMTYN_EDITOR_REGION_XY].dirty || regions[LMTYN_EDITOR_REGION_RENDER].dirty))
+    {
+        /* Reset Mesh vertices/indices */
+        editor->mesh->vertices_size = 0;
+        editor->mesh->indices_size = 0;
 
-    if (editor->wireframe_mode == LMTYN_EDITOR_WIREFRAME_CIRCLE_BOXES)
+        /* Generate Mesh */
+        lmtyn_mesh_generate(editor->mesh, 0, editor->circles, editor->circles_count, editor->mesh_segments);
+    }
+
+    /* The editor updates the index on every edit of a circle, hosts changing circles have to call
+     * lmtyn_editor_circle_index_update_circle or lmtyn_editor_circle_index_update themselves
+     */
+    if (editor->circles_bounds && editor->circles_bounds_count != editor->circles_count)
     {
-        lmtyn_editor_draw_circle_boxes(editor);
+        lmtyn_editor_circle_index_update(editor);
     }
-    else if (editor->wireframe_mode == LMTYN_EDITOR_WIREFRAME_MESH_WIREFRAME)
+
+    /* The views write to disjoint rectangles of the framebuffer */
+    for (i = LMTYN_EDITOR_REGION_XZ; i <= LMTYN_EDITOR_REGION_RENDER; ++i)
     {
-        lmtyn_editor_draw_mesh_wireframe(editor);
+        if (regions[i].dirty)
+        {
+            jobs[jobs_count].editor = editor;
+            jobs[jobs_count].ctx = ctx;
+            jobs[jobs_count].region_index = i;
+            job_data[jobs_count] = &jobs[jobs_count];
+            ++jobs_count;
+        }
+    }
+
+    if (editor->jobs_run && jobs_count > 1)
+    {
+        editor->jobs_run(editor->jobs_context, lmtyn_editor_draw_view_job, job_data, jobs_count);
+    }
+    else
+    {
+        for (i = 0; i < jobs_count; ++i)
+        {
+            lmtyn_editor_draw_view_job(job_data[i]);
+        }
     }
 
-    lmtyn_editor_draw_circles(editor);
+    if (editor->draw_jobs)
+    {
+        lmtyn_editor_draw_lists_execute(editor);
+    }
 
-    lmtyn_mesh_normalize(editor->mesh, 0.0f, 0.0f, 0.0f, 1.0f);
+    for (i = LMTYN_EDITOR_REGION_MENU; i <= LMTYN_EDITOR_REGION_TOOLBAR; ++i)
+    {
+        if (regions[i].dirty)
+        {
+            lmtyn_editor_draw_background(editor, i, editor->framebuffer);
+        }
+    }
 
-    lmtyn_editor_draw_3d_model(editor, ctx);
     lmtyn_editor_draw_borders(editor);
 
     lmtyn_editor_ui_update(editor, input);
@@ -12,6 +12,9 @@ LICENSE
 */
 #include "../lmtyn.h"     /* Lucid Modelling Tool You Need */
 #include "../deps/test.h" /* Simple Testing framework      */
+#ifndef LMTYN_TEST_NO_STATS     /* Also built without them to check that they compile out */
+#define CSR_STATS                 /* Renderer statistics          */
+#endif
 #include "../deps/csr.h"  /* Software Based Renderer       */
 #include "../deps/vm.h"   /* Linear Algebra Library        */
 
@@ -43,9 +46,9 @@ static void csr_save_ppm(char *filename_format, int frame, csr_context *model)
   fclose(fp);
 }
 
-static u8 csr_init(csr_context *ctx, u32 width, u32 height)
+static u8 csr_init(csr_context *ctx, u32 width, u32 height, csr_depth_format depth_format)
 {
-  u32 memory_size = (u32)csr_memory_size((int)width, (int)height);
+  u32 memory_size = (u32)csr_memory_size((int)width, (int)height, depth_format);
   void *memory = (void *)malloc(memory_size);
 
   if (!memory)
@@ -53,7 +56,7 @@ static u8 csr_init(csr_context *ctx, u32 width, u32 height)
     return 0;
   }
 
-  if (!csr_init_model(ctx, memory, memory_size, (int)width, (int)height))
+  if (!csr_init_model(ctx, memory, memory_size, (int)width, (int)height, depth_format))
   {
     return 0;
   }
@@ -61,7 +64,7 @@ static u8 csr_init(csr_context *ctx, u32 width, u32 height)
   return 1;
 }
 
-static void csr_render_mesh(csr_context *ctx, lmtyn_mesh *mesh, v3 cam_position, v3 model_position, u32 frame)
+static void csr_render_mesh(csr_context *ctx, csr_queue *queue, lmtyn_mesh *mesh, float bounding_sphere[4], v3 cam_position, v3 model_position, u32 frame)
 {
   v3 world_up = vm_v3(0.0f, 1.0f, 0.0f);
   v3 cam_look_at_pos = vm_v3(0.0f, 0.5f, 0.0f);
@@ -80,20 +83,840 @@ static void csr_render_mesh(csr_context *ctx, lmtyn_mesh *mesh, v3 cam_position,
       projection_view,
       frame == 0 ? model_base : vm_m4x4_rotate(model_base, vm_radf(5.0f * (float)(frame + 1)), (frame / 100) % 2 == 0 ? model_rotation_x : model_rotation_y));
 
-  /* Render cube */
-  csr_render(
-      ctx,
-      (frame / 50) % 2 == 0
-          ? CSR_RENDER_WIREFRAME
-          : CSR_RENDER_SOLID,
-      CSR_CULLING_CCW_BACKFACE, 3,
-      mesh->vertices, mesh->vertices_size,
-      (int *)mesh->indices, mesh->indices_size,
-      model_view_projection.e);
+  /* Queue mesh, rendered sorted front to back on csr_queue_flush. Wireframes draw the unique edge list. */
+  if ((frame / 50) % 2 == 0)
+  {
+    csr_queue_submit(
+        queue,
+        CSR_RENDER_LINES,
+        CSR_CULLING_DISABLED, 3,
+        mesh->vertices, mesh->vertices_size,
+        (int *)mesh->edges, mesh->edges_size,
+        model_view_projection.e,
+        bounding_sphere);
+  }
+  else
+  {
+    csr_queue_submit(
+        queue,
+        CSR_RENDER_LIT,
+        CSR_CULLING_CCW_BACKFACE, 3,
+        mesh->vertices, mesh->vertices_size,
+        (int *)mesh->indices, mesh->indices_size,
+        model_view_projection.e,
+        bounding_sphere);
+  }
+}
+
+static u8 csr_queue_create(csr_queue *queue, unsigned long capacity)
+{
+  unsigned long memory_size = csr_queue_memory_size(capacity);
+  void *memory = (void *)malloc(memory_size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return (u8)csr_queue_init(queue, memory, memory_size, capacity);
+}
+
+static void csr_queue_test(void)
+{
+  csr_queue queue = {0};
+  float vertices[] = {0.0f, 0.0f, 0.0f};
+  int indices[] = {0, 0, 0};
+  float sphere_near[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  float sphere_mid[4] = {0.0f, 0.0f, -5.0f, 1.0f};
+  float sphere_far[4] = {0.0f, 0.0f, -10.0f, 1.0f};
+  float sphere_behind[4] = {0.0f, 0.0f, 5.0f, 1.0f};
+  float sphere_edge[4] = {0.0f, 0.0f, 2.0f, 1.0f};
+  float planes[CSR_FRUSTUM_PLANE_COUNT * 4];
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 1.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.0f, 2.0f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  csr_frustum_extract_planes(planes, projection_view.e);
+  assert(csr_frustum_test_sphere(planes, sphere_near) == CSR_VISIBILITY_INSIDE);
+  assert(csr_frustum_test_sphere(planes, sphere_behind) == CSR_VISIBILITY_CULLED);
+  assert(csr_frustum_test_sphere(planes, sphere_edge) == CSR_VISIBILITY_INTERSECTING);
+
+  assert(csr_queue_create(&queue, 5));
+
+  /* Submitted back to front and mixed with a wireframe draw */
+  assert(csr_queue_submit(&queue, CSR_RENDER_WIREFRAME, CSR_CULLING_DISABLED, 3, vertices, 3, indices, 3, projection_view.e, sphere_near));
+  assert(csr_queue_submit(&queue, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, vertices, 3, indices, 3, projection_view.e, sphere_far));
+  assert(csr_queue_submit(&queue, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, vertices, 3, indices, 3, projection_view.e, sphere_near));
+  assert(csr_queue_submit(&queue, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, vertices, 3, indices, 3, projection_view.e, sphere_mid));
+  assert(csr_queue_submit(&queue, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, vertices, 3, indices, 3, projection_view.e, sphere_behind));
+  assert(!csr_queue_submit(&queue, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, vertices, 3, indices, 3, projection_view.e, sphere_mid));
+
+  /* Draw behind the camera is culled */
+  csr_queue_cull(&queue);
+  assert(queue.visible == 4);
+  assert(queue.visibility_counts[CSR_VISIBILITY_CULLED] == 1);
+  assert(queue.visibility_counts[CSR_VISIBILITY_INSIDE] == 4);
+
+  /* Solids front to back first, wireframes last */
+  csr_queue_sort(&queue);
+  assert(queue.order[0] == 2);
+  assert(queue.order[1] == 3);
+  assert(queue.order[2] == 1);
+  assert(queue.order[3] == 0);
+
+  free(queue.items);
+}
+
+#define XRGB_TEST_W 64
+#define XRGB_TEST_H 48
+#define XRGB_TEST_STRIDE 80
+#define XRGB_TEST_ORIGIN (5 * XRGB_TEST_STRIDE + 7)
+
+/* Renders the same mesh into a RGB context and into a XRGB sub-rectangle of a larger buffer and compares them */
+static void csr_framebuffer_xrgb_test(lmtyn_mesh *mesh)
+{
+  static unsigned int target[XRGB_TEST_STRIDE * (XRGB_TEST_H + 10)];
+  csr_color clear_color = {40, 40, 40};
+  csr_context ctx_rgb = {0};
+  csr_context ctx_xrgb = {0};
+  unsigned long memory_size_xrgb = csr_memory_size_xrgb(XRGB_TEST_W, XRGB_TEST_H, CSR_DEPTH_F32);
+  void *memory_xrgb = malloc(memory_size_xrgb);
+  int x, y, matches = 1;
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), (f32)XRGB_TEST_W / (f32)XRGB_TEST_H, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 1.4f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  assert(csr_init(&ctx_rgb, XRGB_TEST_W, XRGB_TEST_H, CSR_DEPTH_F32));
+  assert(csr_init_model_xrgb(&ctx_xrgb, memory_xrgb, memory_size_xrgb, target + XRGB_TEST_ORIGIN, XRGB_TEST_STRIDE, XRGB_TEST_W, XRGB_TEST_H, CSR_DEPTH_F32));
+
+  for (x = 0; x < XRGB_TEST_STRIDE * (XRGB_TEST_H + 10); ++x)
+  {
+    target[x] = 0xFFFFFFFF;
+  }
+
+  csr_render_clear_screen(&ctx_rgb, clear_color);
+  csr_render_clear_screen(&ctx_xrgb, clear_color);
+  csr_render(&ctx_rgb, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+  csr_render(&ctx_xrgb, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+
+  for (y = 0; y < XRGB_TEST_H; ++y)
+  {
+    for (x = 0; x < XRGB_TEST_W; ++x)
+    {
+      matches &= csr_color_to_xrgb(ctx_rgb.framebuffer[y * XRGB_TEST_W + x]) == target[XRGB_TEST_ORIGIN + y * XRGB_TEST_STRIDE + x];
+    }
+  }
+
+  assert(matches);
+
+  /* Pixels outside of the sub-rectangle are untouched */
+  assert(target[XRGB_TEST_ORIGIN - 1] == 0xFFFFFFFF);
+  assert(target[XRGB_TEST_ORIGIN + XRGB_TEST_W] == 0xFFFFFFFF);
+  assert(target[XRGB_TEST_ORIGIN + XRGB_TEST_H * XRGB_TEST_STRIDE] == 0xFFFFFFFF);
+
+  free(ctx_rgb.memory);
+  free(memory_xrgb);
+}
+
+/* Renders a moving mesh with an immediate clear and with a deferred clear and compares the resolved frames */
+static void csr_clear_deferred_test(lmtyn_mesh *mesh)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_context ctx_immediate = {0};
+  csr_context ctx_deferred = {0};
+  int frame, i, matches = 1;
+
+  /* Not a multiple of CSR_TILE_SIZE so the border tiles are partial */
+  assert(csr_init(&ctx_immediate, 100, 70, CSR_DEPTH_F32));
+  assert(csr_init(&ctx_deferred, 100, 70, CSR_DEPTH_F32));
+  assert(ctx_deferred.tiles_x == 4 && ctx_deferred.tiles_y == 3);
+
+  for (frame = 0; frame < 4; ++frame)
+  {
+    m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 100.0f / 70.0f, 0.1f, 1000.0f);
+    m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 1.4f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+    m4x4 model = vm_m4x4_translate(vm_m4x4_identity, vm_v3((f32)frame * 0.4f - 0.6f, 0.0f, 0.0f));
+    m4x4 projection_view_model = vm_m4x4_mul(vm_m4x4_mul(projection, view), model);
+
+    csr_render_clear_screen(&ctx_immediate, clear_color);
+    csr_render_clear_screen_deferred(&ctx_deferred, clear_color);
+    csr_render(&ctx_immediate, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view_model.e);
+    csr_render(&ctx_deferred, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view_model.e);
+    csr_render_resolve(&ctx_deferred);
+
+    for (i = 0; i < 100 * 70; ++i)
+    {
+      matches &= csr_color_to_xrgb(ctx_immediate.framebuffer[i]) == csr_color_to_xrgb(ctx_deferred.framebuffer[i]);
+    }
+  }
+
+  assert(matches);
+
+  /* The mesh only covers part of the screen so some tiles never had their depth cleared */
+  {
+    int untouched = 0;
+
+    for (i = 0; i < ctx_deferred.tiles_x * ctx_deferred.tiles_y; ++i)
+    {
+      untouched += ctx_deferred.tiles[i] == CSR_TILE_CLEAR_COLOR;
+    }
+
+    assert(untouched > 0);
+  }
+
+  free(ctx_immediate.memory);
+  free(ctx_deferred.memory);
+}
+
+/* Renders the same mesh with every depth format, the unorm formats have to resolve visibility like the float zbuffer */
+static void csr_depth_format_test(lmtyn_mesh *mesh)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_depth_format formats[3];
+  csr_context ctx[3];
+  int i, f, mismatches[3] = {0};
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 160.0f / 120.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 1.4f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  formats[0] = CSR_DEPTH_F32;
+  formats[1] = CSR_DEPTH_U16;
+  formats[2] = CSR_DEPTH_U24;
+
+  assert(csr_memory_size(160, 120, CSR_DEPTH_U16) < csr_memory_size(160, 120, CSR_DEPTH_U24));
+  assert(csr_memory_size(160, 120, CSR_DEPTH_U24) < csr_memory_size(160, 120, CSR_DEPTH_F32));
+
+  for (f = 0; f < 3; ++f)
+  {
+    assert(csr_init(&ctx[f], 160, 120, formats[f]));
+
+    /* Wireframe on top of the solid mesh exercises the line depth test as well */
+    csr_render_clear_screen(&ctx[f], clear_color);
+    csr_render(&ctx[f], CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+    csr_render(&ctx[f], CSR_RENDER_WIREFRAME, CSR_CULLING_DISABLED, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+  }
+
+  for (f = 1; f < 3; ++f)
+  {
+    for (i = 0; i < 160 * 120; ++i)
+    {
+      mismatches[f] += csr_color_to_xrgb(ctx[0].framebuffer[i]) != csr_color_to_xrgb(ctx[f].framebuffer[i]);
+    }
+  }
+
+  /* Only the coplanar wireframe lines may resolve differently */
+  assert(mismatches[1] < (160 * 120) / 100);
+  assert(mismatches[2] < (160 * 120) / 100);
+
+  for (f = 0; f < 3; ++f)
+  {
+    free(ctx[f].memory);
+  }
+}
+
+/* Thin and steep triangles keep the fixed point depth of the unorm formats at every covered pixel */
+static void csr_depth_sliver_test(void)
+{
+  csr_depth_format formats[2];
+  csr_context ctx;
+  int f, x, y, covered;
+
+  /* 188 pixel long diagonal sliver, 4 pixels thick at its far end, the depth spans most of the range across it */
+  float p0[3] = {10.0f, 10.0f, -0.9f};
+  float p1[3] = {143.0f, 143.0f, -0.9f};
+  float p2[3] = {145.83f, 140.17f, 0.9f};
+
+  formats[0] = CSR_DEPTH_U16;
+  formats[1] = CSR_DEPTH_U24;
+
+  for (f = 0; f < 2; ++f)
+  {
+    int bits = csr_depth_bits(formats[f]);
+    double max_depth = (double)((1UL << bits) - 1UL);
+    double max_error = 0.0;
+
+    assert(csr_init(&ctx, 160, 160, formats[f]));
+    csr_clear_rect_depth(&ctx, 0, 0, 160, 160);
+    csr_draw_triangle(&ctx, p0, p1, p2, csr_init_color(255, 0, 0), csr_init_color(255, 0, 0), csr_init_color(255, 0, 0));
+
+    covered = 0;
+
+    for (y = 0; y < 160; ++y)
+    {
+      for (x = 0; x < 160; ++x)
+      {
+        int index = y * 160 + x;
+        float area = (p1[1] - p2[1]) * (p0[0] - p2[0]) + (p2[0] - p1[0]) * (p0[1] - p2[1]);
+        float w2 = ((p0[1] - p1[1]) * ((float)x - p1[0]) + (p1[0] - p0[0]) * ((float)y - p1[1])) / area;
+        float z = p0[2] + (p2[2] - p0[2]) * w2;
+        double stored;
+        double error;
+
+        if (bits == 16)
+        {
+          stored = (double)ctx.zbuffer_u16[index];
+        }
+        else
+        {
+          unsigned char *d = ctx.zbuffer_u24 + index * 3;
+          stored = (double)((unsigned int)d[0] | ((unsigned int)d[1] << 8) | ((unsigned int)d[2] << 16));
+        }
+
+        if (stored == max_depth)
+        {
+          continue;
+        }
+
+        ++covered;
+
+        error = stored - (double)((z + 1.0f) * 0.5f) * max_depth;
+        error = error < 0.0 ? -error : error;
+        max_error = error > max_error ? error : max_error;
+      }
+    }
+
+    /* Truncation and float rounding of the plane stay within a few units of the last place */
+    assert(covered > 188);
+    assert(max_error < max_depth / 65535.0 * 2.0);
+
+    free(ctx.memory);
+  }
+}
+
+/* Thin triangles interpolate the vertex colors at every covered pixel */
+static void csr_color_sliver_test(void)
+{
+  csr_depth_format formats[2];
+  csr_context ctx;
+  int f, x, y, covered;
+
+  /* Same sliver as the depth test with a red gradient across its short axis */
+  float p0[3] = {10.0f, 10.0f, -0.9f};
+  float p1[3] = {143.0f, 143.0f, -0.9f};
+  float p2[3] = {145.83f, 140.17f, 0.9f};
+
+  formats[0] = CSR_DEPTH_F32;
+  formats[1] = CSR_DEPTH_U16;
+
+  for (f = 0; f < 2; ++f)
+  {
+    assert(csr_init(&ctx, 160, 160, formats[f]));
+    csr_render_clear_screen(&ctx, csr_init_color(0, 0, 0));
+    csr_draw_triangle(&ctx, p0, p1, p2, csr_init_color(0, 255, 0), csr_init_color(0, 255, 0), csr_init_color(255, 255, 0));
+
+    covered = 0;
+
+    for (y = 0; y < 160; ++y)
+    {
+      for (x = 0; x < 160; ++x)
+      {
+        csr_color pixel = ctx.framebuffer[y * 160 + x];
+        float area = (p1[1] - p2[1]) * (p0[0] - p2[0]) + (p2[0] - p1[0]) * (p0[1] - p2[1]);
+        float w2 = ((p0[1] - p1[1]) * ((float)x - p1[0]) + (p1[0] - p0[0]) * ((float)y - p1[1])) / area;
+        int expected = (int)(csr_minf(csr_maxf(w2, 0.0f), 1.0f) * 255.0f);
+
+        if (pixel.g == 0)
+        {
+          continue;
+        }
+
+        ++covered;
+
+        assert(pixel.g == 255 && pixel.b == 0);
+        assert((int)pixel.r == expected);
+      }
+    }
+
+    assert(covered > 188);
+
+    free(ctx.memory);
+  }
+}
+
+/* Geometry crossing the near plane or far outside of the viewport has to be clipped instead of dropped */
+static void csr_clipping_test(void)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_context ctx = {0};
+  int x, y, covered;
+
+  /* Floor reaching from behind the camera far into the scene */
+  float floor_vertices[] = {
+      -1.0f, -0.5f, 5.0f,
+      1.0f, -0.5f, 5.0f,
+      1.0f, -0.5f, -5.0f,
+      -1.0f, -0.5f, -5.0f};
+  int floor_indices[] = {0, 1, 2, 0, 2, 3};
+
+  /* Triangle hundreds of viewports wide in front of the camera */
+  float huge_vertices[] = {
+      -1000.0f, -1000.0f, -1.0f,
+      1000.0f, -1000.0f, -1.0f,
+      0.0f, 1000.0f, -1.0f};
+  int huge_indices[] = {0, 1, 2};
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 64.0f / 48.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3_zero, vm_v3(0.0f, 0.0f, -1.0f), vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  assert(csr_init(&ctx, 64, 48, CSR_DEPTH_F32));
+
+  csr_render_clear_screen(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, floor_vertices, 4, floor_indices, 6, projection_view.e);
+
+  /* The floor directly below the camera is visible, the sky above the horizon is not */
+  assert(csr_color_to_xrgb(ctx.framebuffer[47 * 64 + 32]) != csr_color_to_xrgb(clear_color));
+  assert(csr_color_to_xrgb(ctx.framebuffer[0 * 64 + 32]) == csr_color_to_xrgb(clear_color));
+
+  csr_render_clear_screen(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, huge_vertices, 3, huge_indices, 3, projection_view.e);
+
+  covered = 1;
+
+  for (y = 0; y < 48; ++y)
+  {
+    for (x = 0; x < 64; ++x)
+    {
+      covered &= csr_color_to_xrgb(ctx.framebuffer[y * 64 + x]) != csr_color_to_xrgb(clear_color);
+    }
+  }
+
+  assert(covered);
+
+  /* Lines reaching far outside of the viewport only touch the visible pixels of their row */
+  {
+    float line_start[3] = {-100000.0f, 10.0f, 0.0f};
+    float line_end[3] = {100000.0f, 10.0f, 0.0f};
+    float outside_start[3] = {-500.0f, -20.0f, 0.0f};
+    float outside_end[3] = {500.0f, -20.0f, 0.0f};
+    int row = 1, others = 1;
+
+    csr_render_clear_screen(&ctx, clear_color);
+    csr_draw_line(&ctx, line_start, line_end, csr_init_color(255, 255, 255));
+    csr_draw_line(&ctx, outside_start, outside_end, csr_init_color(255, 255, 255));
+
+    for (y = 0; y < 48; ++y)
+    {
+      for (x = 0; x < 64; ++x)
+      {
+        int set = csr_color_to_xrgb(ctx.framebuffer[y * 64 + x]) == 0xFFFFFF;
+        row &= (y != 10) || set;
+        others &= (y == 10) || !set;
+      }
+    }
+
+    assert(row);
+    assert(others);
+  }
+
+  free(ctx.memory);
+}
+
+#ifdef CSR_STATS
+/* Statistics have to account for every submitted triangle and every tested pixel */
+static void csr_stats_test(lmtyn_mesh *mesh)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_context ctx = {0};
+  csr_stats stats;
+
+  float behind_vertices[] = {
+      -1.0f, 0.0f, 10.0f,
+      1.0f, 0.0f, 10.0f,
+      0.0f, 1.0f, 10.0f};
+  int behind_indices[] = {0, 1, 2};
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 160.0f / 120.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 6.0f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  assert(csr_init(&ctx, 160, 120, CSR_DEPTH_F32));
+  assert(ctx.stats == 0);
+
+  csr_stats_reset(&stats);
+  ctx.stats = &stats;
+
+  csr_render_clear_screen(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+
+  assert(stats.triangles_submitted == mesh->indices_size / 3);
+  assert(stats.triangles_clipped == 0);
+  assert(stats.triangles_culled_backface > 0);
+  assert(stats.triangles_rasterized + stats.triangles_culled_backface + stats.triangles_culled_offscreen + stats.triangles_culled_near == stats.triangles_submitted);
+  assert(stats.pixels_written > 0);
+  assert(stats.pixels_tested == stats.pixels_written + stats.depth_rejects);
+  assert(stats.render_time > 0.0);
+
+  /* The same mesh again at the same depth does not pass the depth test anywhere */
+  csr_stats_reset(&stats);
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+  assert(stats.pixels_tested > 0);
+  assert(stats.pixels_written == 0);
+
+  csr_stats_reset(&stats);
+  csr_render(&ctx, CSR_RENDER_LINES, CSR_CULLING_DISABLED, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->edges, mesh->edges_size, projection_view.e);
+  assert(stats.lines_submitted == mesh->edges_size / 2);
+  assert(stats.lines_rasterized + stats.lines_culled == stats.lines_submitted);
+  assert(stats.pixels_tested == stats.pixels_written + stats.depth_rejects);
+
+  csr_stats_reset(&stats);
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, behind_vertices, 3, behind_indices, 3, projection_view.e);
+  assert(stats.triangles_culled_near == 1);
+  assert(stats.triangles_rasterized == 0);
+
+  free(ctx.memory);
+}
+#endif
+
+/* Faces towards the light get the full surface color, faces turned away only the ambient term */
+static void csr_lit_test(void)
+{
+  csr_color clear_color = {0, 0, 0};
+  csr_color surface = {200, 100, 50};
+  csr_context ctx = {0};
+  int x, y, uniform = 1;
+
+  float front_vertices[] = {
+      -1.0f, -1.0f, 0.0f,
+      1.0f, -1.0f, 0.0f,
+      0.0f, 1.0f, 0.0f};
+  int front_indices[] = {0, 2, 1};
+  int back_indices[] = {0, 1, 2};
+
+  /* Position, color and a normal towards the light, wound away from it */
+  float normal_vertices[] = {
+      -1.0f, -1.0f, 0.0f, 10.0f, 20.0f, 30.0f, 0.0f, 0.0f, 1.0f,
+      1.0f, -1.0f, 0.0f, 10.0f, 20.0f, 30.0f, 0.0f, 0.0f, 1.0f,
+      0.0f, 1.0f, 0.0f, 10.0f, 20.0f, 30.0f, 0.0f, 0.0f, 1.0f};
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 64.0f / 48.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.0f, 1.5f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  assert(csr_init(&ctx, 64, 48, CSR_DEPTH_F32));
+  csr_light_init(&ctx, 0.0f, 0.0f, 2.0f, 0.25f, surface);
+
+  csr_render_clear_screen(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_LIT, CSR_CULLING_DISABLED, 3, front_vertices, 3, front_indices, 3, projection_view.e);
+  assert(csr_color_to_xrgb(ctx.framebuffer[24 * 64 + 32]) == csr_color_to_xrgb(surface));
+
+  /* Flat shading has a single color across the whole face */
+  for (y = 0; y < 48; ++y)
+  {
+    for (x = 0; x < 64; ++x)
+    {
+      unsigned int color = csr_color_to_xrgb(ctx.framebuffer[y * 64 + x]);
+      uniform &= (color == csr_color_to_xrgb(clear_color) || color == csr_color_to_xrgb(surface));
+    }
+  }
+
+  assert(uniform);
+
+  csr_render_clear_screen(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_LIT, CSR_CULLING_DISABLED, 3, front_vertices, 3, back_indices, 3, projection_view.e);
+  assert(ctx.framebuffer[24 * 64 + 32].r == 50);
+  assert(ctx.framebuffer[24 * 64 + 32].g == 25);
+  assert(ctx.framebuffer[24 * 64 + 32].b == 12);
+
+  /* Vertex normals win over the face normal and vertex colors over the light color */
+  csr_render_clear_screen(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_LIT, CSR_CULLING_DISABLED, 9, normal_vertices, 3, back_indices, 3, projection_view.e);
+  assert(ctx.framebuffer[24 * 64 + 32].r == 10);
+  assert(ctx.framebuffer[24 * 64 + 32].g == 20);
+  assert(ctx.framebuffer[24 * 64 + 32].b == 30);
+
+  free(ctx.memory);
+}
+
+/* The overdraw counters have to cover exactly the pixels a solid render covers */
+static void csr_overdraw_test(lmtyn_mesh *mesh)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_context solid = {0};
+  csr_context ctx = {0};
+  unsigned long memory_size = csr_overdraw_memory_size(160, 120);
+  void *memory = malloc(memory_size);
+  int i, same_coverage = 1, writes_below_tests = 1, tiles_counted = 0;
+  unsigned int max_tests = 0;
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 160.0f / 120.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 1.4f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  assert(csr_init(&solid, 160, 120, CSR_DEPTH_F32));
+  assert(csr_init(&ctx, 160, 120, CSR_DEPTH_F32));
+  assert(!csr_overdraw_init(&ctx, memory, memory_size - 1));
+  assert(csr_overdraw_init(&ctx, memory, memory_size));
+
+  csr_render_clear_screen(&solid, clear_color);
+  csr_render(&solid, CSR_RENDER_SOLID, CSR_CULLING_DISABLED, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+
+  csr_render_clear_screen_deferred(&ctx, clear_color);
+  csr_render(&ctx, CSR_RENDER_OVERDRAW, CSR_CULLING_DISABLED, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+
+  for (i = 0; i < 160 * 120; ++i)
+  {
+    unsigned int tests = ctx.overdraw[i * 2];
+    unsigned int writes = ctx.overdraw[i * 2 + 1];
+
+    same_coverage &= (tests > 0) == (csr_color_to_xrgb(solid.framebuffer[i]) != csr_color_to_xrgb(clear_color));
+    writes_below_tests &= writes <= tests && (tests == 0 || writes > 0);
+    max_tests = tests > max_tests ? tests : max_tests;
+  }
+
+  for (i = 0; i < ctx.tiles_x * ctx.tiles_y; ++i)
+  {
+    tiles_counted += ctx.overdraw_tiles[i] > 0;
+  }
+
+  assert(same_coverage);
+  assert(writes_below_tests);
+  assert(max_tests >= 2); /* front and back faces of the closed pillar */
+  assert(tiles_counted > 0);
+
+  /* The untouched background is black in the heatmap, covered pixels are not */
+  csr_overdraw_resolve(&ctx, CSR_OVERDRAW_TESTS, 4);
+  assert(ctx.tiles_deferred == 0);
+  assert(csr_color_to_xrgb(ctx.framebuffer[0]) == 0);
+  assert(csr_color_to_xrgb(ctx.framebuffer[60 * 160 + 80]) != 0);
+  assert(csr_color_to_xrgb(csr_overdraw_heatmap(4, 4)) == 0xFF0000);
+  assert(csr_color_to_xrgb(csr_overdraw_heatmap(5, 4)) == 0xFFFFFF);
+
+  csr_overdraw_clear(&ctx);
+  assert(ctx.overdraw[60 * 160 * 2 + 80 * 2] == 0);
+
+  free(memory);
+  free(solid.memory);
+  free(ctx.memory);
+}
+
+/* Every covered pixel has to name the draw and a triangle that covers it */
+static void csr_visibility_buffer_test(lmtyn_mesh *mesh)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_context ctx = {0};
+  csr_context single = {0};
+  unsigned long memory_size = csr_visibility_buffer_size(160, 120);
+  void *memory = malloc(memory_size);
+  int i, same_coverage = 1, same_draw = 1, valid_primitive = 1;
+  int picked_pixel = -1;
+  unsigned int picked;
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 160.0f / 120.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 1.4f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  assert(csr_init(&ctx, 160, 120, CSR_DEPTH_U16));
+  assert(csr_visibility_buffer_init(&ctx, memory, memory_size));
+
+  csr_render_clear_screen_deferred(&ctx, clear_color);
+  assert(csr_visibility_buffer_pick(&ctx, 80, 60) == CSR_PRIMITIVE_ID_NONE);
+
+  ctx.draw_id = 7;
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+  csr_render_resolve(&ctx);
+
+  for (i = 0; i < 160 * 120; ++i)
+  {
+    unsigned int id = csr_visibility_buffer_pick(&ctx, i % 160, i / 160);
+
+    same_coverage &= (id != CSR_PRIMITIVE_ID_NONE) == (csr_color_to_xrgb(ctx.framebuffer[i]) != csr_color_to_xrgb(clear_color));
+
+    if (id != CSR_PRIMITIVE_ID_NONE)
+    {
+      same_draw &= csr_primitive_id_draw(id) == 7;
+      valid_primitive &= csr_primitive_id_primitive(id) < mesh->indices_size / 3;
+
+      /* Covered pixel closest to the center of the screen */
+      if (picked_pixel < 0 || csr_absi(i % 160 - 80) + csr_absi(i / 160 - 60) < csr_absi(picked_pixel % 160 - 80) + csr_absi(picked_pixel / 160 - 60))
+      {
+        picked_pixel = i;
+      }
+    }
+  }
+
+  assert(same_coverage);
+  assert(same_draw);
+  assert(valid_primitive);
+
+  /* Binding the buffer again, as a renderer does every frame, keeps the ids until the next depth clear */
+  assert(picked_pixel >= 0);
+  picked = csr_visibility_buffer_pick(&ctx, picked_pixel % 160, picked_pixel / 160);
+  assert(csr_visibility_buffer_init(&ctx, memory, memory_size));
+  assert(csr_visibility_buffer_pick(&ctx, picked_pixel % 160, picked_pixel / 160) == picked);
+
+  /* The picked triangle alone covers the picked pixel */
+  picked = csr_primitive_id_primitive(picked);
+  assert(picked < mesh->indices_size / 3);
+  assert(csr_init(&single, 160, 120, CSR_DEPTH_F32));
+  csr_render_clear_screen(&single, clear_color);
+  csr_render(&single, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices + picked * 3, 3, projection_view.e);
+  assert(csr_color_to_xrgb(single.framebuffer[picked_pixel]) != csr_color_to_xrgb(clear_color));
+
+  /* Draws beyond the id range are counted and leave no id instead of wrapping into the ids of other draws */
+  assert(csr_primitive_id(CSR_DRAW_ID_MAX, CSR_PRIMITIVE_ID_MASK) != CSR_PRIMITIVE_ID_NONE);
+  assert(csr_primitive_id(CSR_DRAW_ID_MAX + 1U, 0) == CSR_PRIMITIVE_ID_NONE);
+  assert(csr_primitive_id(0, CSR_PRIMITIVE_ID_MASK + 1UL) == CSR_PRIMITIVE_ID_NONE);
+  assert(ctx.primitive_id_overflows == 0);
+
+  csr_render_clear_screen_deferred(&ctx, clear_color);
+  ctx.draw_id = CSR_DRAW_ID_MAX + 1U + 7U;
+  csr_render(&ctx, CSR_RENDER_SOLID, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e);
+  csr_render_resolve(&ctx);
+
+  assert(ctx.primitive_id_overflows == 1);
+  assert(csr_visibility_buffer_pick(&ctx, 80, 60) == CSR_PRIMITIVE_ID_NONE);
+
+  free(memory);
+  free(single.memory);
+  free(ctx.memory);
+}
+
+/* Instanced draws match one csr_render per instance, with and without the vertex cache */
+static void csr_render_instanced_test(lmtyn_mesh *mesh)
+{
+  csr_color clear_color = {40, 40, 40};
+  csr_context reference = {0};
+  csr_context cached = {0};
+  csr_context uncached = {0};
+  unsigned long memory_size = csr_instance_memory_size(3, mesh->vertices_size);
+  void *memory = malloc(memory_size);
+  float *vertices = (float *)malloc(sizeof(float) * mesh->vertices_size);
+  float model_matrices[4 * 16];
+  float bounding_sphere[4];
+  int i, same_cached = 1, same_uncached = 1, same_exact = 1, covered = 0;
+
+  /* Three instances in a row in front of the camera and one behind it */
+  v3 positions[4];
+
+  m4x4 projection = vm_m4x4_perspective(vm_radf(90.0f), 160.0f / 120.0f, 0.1f, 1000.0f);
+  m4x4 view = vm_m4x4_lookAt(vm_v3(0.0f, 0.6f, 2.5f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f));
+  m4x4 projection_view = vm_m4x4_mul(projection, view);
+
+  positions[0] = vm_v3(-1.0f, 0.0f, 0.0f);
+  positions[1] = vm_v3(0.0f, 0.0f, 0.0f);
+  positions[2] = vm_v3(1.0f, 0.0f, 0.0f);
+  positions[3] = vm_v3(0.0f, 0.0f, 50.0f);
+
+  csr_bounding_sphere(bounding_sphere, 3, mesh->vertices, (int *)mesh->indices, mesh->indices_size);
+
+  assert(csr_init(&reference, 160, 120, CSR_DEPTH_F32));
+  assert(csr_init(&cached, 160, 120, CSR_DEPTH_F32));
+  assert(csr_init(&uncached, 160, 120, CSR_DEPTH_F32));
+  assert(!csr_instance_init(&cached, memory, 4));
+  assert(csr_instance_init(&cached, memory, memory_size));
+  assert(cached.instance_vertices_capacity >= mesh->vertices_size / 3);
+  assert(cached.instance_vertices_capacity <= mesh->vertices_size / 3 + 1);
+
+  csr_render_clear_screen(&reference, clear_color);
+  csr_render_clear_screen(&cached, clear_color);
+  csr_render_clear_screen(&uncached, clear_color);
+
+  for (i = 0; i < 4; ++i)
+  {
+    float projection_view_model[16];
+    m4x4 model = vm_m4x4_translate(vm_m4x4_identity, positions[i]);
+    int e;
+
+    for (e = 0; e < 16; ++e)
+    {
+      model_matrices[i * 16 + e] = model.e[e];
+    }
+
+    csr_m4x4_mul(projection_view_model, projection_view.e, model.e);
+    csr_render(&reference, CSR_RENDER_LIT, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view_model);
+  }
+
+  assert(csr_render_instanced(&cached, CSR_RENDER_LIT, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e, model_matrices, 4, bounding_sphere) == 3);
+  assert(csr_render_instanced(&uncached, CSR_RENDER_LIT, CSR_CULLING_CCW_BACKFACE, 3, mesh->vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e, model_matrices, 4, bounding_sphere) == 3);
+
+  for (i = 0; i < 160 * 120; ++i)
+  {
+    same_cached &= csr_color_to_xrgb(cached.framebuffer[i]) == csr_color_to_xrgb(reference.framebuffer[i]);
+    same_uncached &= csr_color_to_xrgb(uncached.framebuffer[i]) == csr_color_to_xrgb(reference.framebuffer[i]);
+    covered += csr_color_to_xrgb(reference.framebuffer[i]) != csr_color_to_xrgb(clear_color);
+  }
+
+  assert(covered > 0);
+  assert(same_cached);
+  assert(same_uncached);
+
+  /* The cache only reads the vertices of the mesh, checked against a vertex buffer without spare capacity */
+  for (i = 0; i < (int)mesh->vertices_size; ++i)
+  {
+    vertices[i] = mesh->vertices[i];
+  }
+
+  csr_render_clear_screen(&cached, clear_color);
+  assert(csr_render_instanced(&cached, CSR_RENDER_LIT, CSR_CULLING_CCW_BACKFACE, 3, vertices, mesh->vertices_size, (int *)mesh->indices, mesh->indices_size, projection_view.e, model_matrices, 4, bounding_sphere) == 3);
+
+  for (i = 0; i < 160 * 120; ++i)
+  {
+    same_exact &= csr_color_to_xrgb(cached.framebuffer[i]) == csr_color_to_xrgb(reference.framebuffer[i]);
+  }
+
+  assert(same_exact);
+
+  free(vertices);
+  free(memory);
+  free(reference.memory);
+  free(cached.memory);
+  free(uncached.memory);
+}
+
+/* Triangles of a generated mesh map back to the circle and segment they were generated from:
+ * ring vertices of a triangle lie on the circle or the next one at the segment or the next one,
+ * cap triangles use the center vertex of their circle.
+ */
+static void lmtyn_mesh_triangle_source_test(lmtyn_mesh *mesh, lmtyn_shape_circle *circles, u32 circles_count, u32 segments)
+{
+  u32 ring_vertices = circles_count * segments;
+  u32 triangles = mesh->indices_size / 3;
+  u32 t, k;
+
+  for (t = 0; t < triangles; ++t)
+  {
+    u32 circle = 0, segment = 0;
+    u8 on_source = 1, has_source = 0;
+
+    assert(lmtyn_mesh_triangle_source(circles, circles_count, segments, t, &circle, &segment));
+
+    for (k = 0; k < 3; ++k)
+    {
+      u32 vertex = mesh->indices[t * 3 + k];
+
+      if (vertex < ring_vertices)
+      {
+        u32 ring = vertex / segments;
+        u32 ring_segment = vertex % segments;
+
+        on_source &= (u8)((ring == circle || ring == (circle + 1) % circles_count) &&
+                          (ring_segment == segment || ring_segment == (segment + 1) % segments));
+        has_source |= (u8)(ring == circle && ring_segment == segment);
+      }
+      else
+      {
+        /* cap center, the bottom one is generated first */
+        on_source &= (u8)(vertex - ring_vertices == (circle == 0 ? 0U : 1U));
+      }
+    }
+
+    assert(on_source);
+    assert(has_source);
+  }
+
+  {
+    u32 circle = 0, segment = 0;
+    assert(!lmtyn_mesh_triangle_source(circles, circles_count, segments, triangles, &circle, &segment));
+  }
 }
 
 #define NUM_VERTICES 512
 #define NUM_INDICES 512
+#define NUM_EDGES 512
 
 static void lmtyn_create_mesh(lmtyn_mesh *mesh, lmtyn_shape_circle *circles, u32 circles_count, u32 segments)
 {
@@ -101,9 +924,77 @@ static void lmtyn_create_mesh(lmtyn_mesh *mesh, lmtyn_shape_circle *circles, u32
   mesh->indices_capacity = sizeof(u32) * NUM_INDICES;
   mesh->vertices = malloc(sizeof(f32) * mesh->vertices_capacity);
   mesh->indices = malloc(sizeof(u32) * mesh->indices_capacity);
+  mesh->edges_capacity = sizeof(u32) * NUM_EDGES;
+  mesh->edges = malloc(sizeof(u32) * mesh->edges_capacity);
 
   assert(lmtyn_mesh_generate(mesh, 0, circles, circles_count, segments));
   assert(lmtyn_mesh_normalize(mesh, 0.0f, 0.0f, 0.0f, 1.0f));
+
+  /* Normalized meshes are centered at the origin with a largest extent of 1 */
+  {
+    f32 center[3];
+    f32 size;
+
+    assert(lmtyn_mesh_bounds(mesh, center, &size));
+    assert(center[0] > -1e-5f && center[0] < 1e-5f);
+    assert(center[1] > -1e-5f && center[1] < 1e-5f);
+    assert(center[2] > -1e-5f && center[2] < 1e-5f);
+    assert(size > 0.9999f && size < 1.0001f);
+  }
+}
+
+static u8 lmtyn_mesh_has_edge(u32 *edges, u32 edges_size, u32 a, u32 b)
+{
+  u32 i;
+
+  for (i = 0; i + 1 < edges_size; i += 2)
+  {
+    if ((edges[i] == a && edges[i + 1] == b) || (edges[i] == b && edges[i + 1] == a))
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/* The edge list has to contain every triangle edge exactly once and nothing else */
+static void lmtyn_mesh_edges_test(lmtyn_mesh *mesh)
+{
+  u8 unique = 1, complete = 1, from_triangles = 1;
+  u32 i, j;
+
+  assert(mesh->edges_size > 0 && mesh->edges_size % 2 == 0);
+
+  for (i = 0; i + 1 < mesh->edges_size; i += 2)
+  {
+    u8 found = 0;
+
+    unique &= !lmtyn_mesh_has_edge(mesh->edges + i + 2, mesh->edges_size - i - 2, mesh->edges[i], mesh->edges[i + 1]);
+
+    for (j = 0; j + 2 < mesh->indices_size; j += 3)
+    {
+      u32 *t = &mesh->indices[j];
+      found |= lmtyn_mesh_has_edge(t, 2, mesh->edges[i], mesh->edges[i + 1]) ||
+               lmtyn_mesh_has_edge(t + 1, 2, mesh->edges[i], mesh->edges[i + 1]) ||
+               (t[2] == mesh->edges[i] && t[0] == mesh->edges[i + 1]) ||
+               (t[0] == mesh->edges[i] && t[2] == mesh->edges[i + 1]);
+    }
+
+    from_triangles &= found;
+  }
+
+  for (j = 0; j + 2 < mesh->indices_size; j += 3)
+  {
+    u32 *t = &mesh->indices[j];
+    complete &= lmtyn_mesh_has_edge(mesh->edges, mesh->edges_size, t[0], t[1]);
+    complete &= lmtyn_mesh_has_edge(mesh->edges, mesh->edges_size, t[1], t[2]);
+    complete &= lmtyn_mesh_has_edge(mesh->edges, mesh->edges_size, t[2], t[0]);
+  }
+
+  assert(unique);
+  assert(complete);
+  assert(from_triangles);
 }
 
 int main(void)
@@ -185,6 +1076,28 @@ int main(void)
   lmtyn_create_mesh(&mesh_pipe, pipe, sizeof(pipe) / sizeof(pipe[0]), 16);
   lmtyn_create_mesh(&mesh_tower, tower, sizeof(tower) / sizeof(tower[0]), 8);
 
+  lmtyn_mesh_edges_test(&mesh_arc);
+  lmtyn_mesh_edges_test(&mesh_circle);
+  lmtyn_mesh_edges_test(&mesh_pipe);
+  lmtyn_mesh_edges_test(&mesh_tower);
+
+  csr_queue_test();
+  csr_framebuffer_xrgb_test(&mesh_pillar);
+  csr_clear_deferred_test(&mesh_pillar);
+  csr_depth_format_test(&mesh_pillar);
+  csr_depth_sliver_test();
+  csr_color_sliver_test();
+  csr_clipping_test();
+  csr_lit_test();
+#ifdef CSR_STATS
+  csr_stats_test(&mesh_pillar);
+#endif
+  csr_overdraw_test(&mesh_pillar);
+  csr_visibility_buffer_test(&mesh_pillar);
+  csr_render_instanced_test(&mesh_pillar);
+  lmtyn_mesh_triangle_source_test(&mesh_pillar, pillar, sizeof(pillar) / sizeof(pillar[0]), 8);
+  lmtyn_mesh_triangle_source_test(&mesh_circle, circle, sizeof(circle) / sizeof(circle[0]), 4);
+
   /* #############################################################################
    * # Render to PPM Frames
    * #############################################################################
@@ -192,21 +1105,39 @@ int main(void)
   {
     csr_color clear_color = {40, 40, 40};
     csr_context ctx = {0};
+    csr_queue queue = {0};
+
+    float sphere_arc[4];
+    float sphere_pillar[4];
+    float sphere_circle[4];
+    float sphere_lamp[4];
+    float sphere_pipe[4];
+    float sphere_tower[4];
 
     u32 frame;
     v3 cam_position = vm_v3(0.0f, 0.6f, 1.4f);
 
-    assert(csr_init(&ctx, 600, 400));
+    assert(csr_init(&ctx, 600, 400, CSR_DEPTH_F32));
+    assert(csr_queue_create(&queue, 16));
+
+    csr_bounding_sphere(sphere_arc, 3, mesh_arc.vertices, (int *)mesh_arc.indices, mesh_arc.indices_size);
+    csr_bounding_sphere(sphere_pillar, 3, mesh_pillar.vertices, (int *)mesh_pillar.indices, mesh_pillar.indices_size);
+    csr_bounding_sphere(sphere_circle, 3, mesh_circle.vertices, (int *)mesh_circle.indices, mesh_circle.indices_size);
+    csr_bounding_sphere(sphere_lamp, 3, mesh_lamp.vertices, (int *)mesh_lamp.indices, mesh_lamp.indices_size);
+    csr_bounding_sphere(sphere_pipe, 3, mesh_pipe.vertices, (int *)mesh_pipe.indices, mesh_pipe.indices_size);
+    csr_bounding_sphere(sphere_tower, 3, mesh_tower.vertices, (int *)mesh_tower.indices, mesh_tower.indices_size);
 
     for (frame = 0; frame < 200; ++frame)
     {
-      csr_render_clear_screen(&ctx, clear_color);
-      csr_render_mesh(&ctx, &mesh_arc, cam_position, vm_v3(-1.0f, 0.0f, 0.0f), frame);
-      csr_render_mesh(&ctx, &mesh_pillar, cam_position, vm_v3_zero, frame);
-      csr_render_mesh(&ctx, &mesh_circle, cam_position, vm_v3(1.0f, 0.0f, 0.0f), frame);
-      csr_render_mesh(&ctx, &mesh_lamp, cam_position, vm_v3(-1.0f, 1.0f, 0.0f), frame);
-      csr_render_mesh(&ctx, &mesh_pipe, cam_position, vm_v3(0.0f, 1.0f, 0.0f), frame);
-      csr_render_mesh(&ctx, &mesh_tower, cam_position, vm_v3(1.0f, 1.0f, 0.0f), frame);
+      csr_render_clear_screen_deferred(&ctx, clear_color);
+      csr_render_mesh(&ctx, &queue, &mesh_arc, sphere_arc, cam_position, vm_v3(-1.0f, 0.0f, 0.0f), frame);
+      csr_render_mesh(&ctx, &queue, &mesh_pillar, sphere_pillar, cam_position, vm_v3_zero, frame);
+      csr_render_mesh(&ctx, &queue, &mesh_circle, sphere_circle, cam_position, vm_v3(1.0f, 0.0f, 0.0f), frame);
+      csr_render_mesh(&ctx, &queue, &mesh_lamp, sphere_lamp, cam_position, vm_v3(-1.0f, 1.0f, 0.0f), frame);
+      csr_render_mesh(&ctx, &queue, &mesh_pipe, sphere_pipe, cam_position, vm_v3(0.0f, 1.0f, 0.0f), frame);
+      csr_render_mesh(&ctx, &queue, &mesh_tower, sphere_tower, cam_position, vm_v3(1.0f, 1.0f, 0.0f), frame);
+      csr_queue_flush(&ctx, &queue);
+      csr_render_resolve(&ctx);
       csr_save_ppm("test_%05d.ppm", (int)frame, &ctx);
     }
   }
@@ -1,29 +1,12 @@
+/* windows.h comes first so deps/perf.h uses its declarations instead of its own */
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 #include "lmtyn.h"        /* The modelling algorithm */
 #include "lmtyn_editor.h" /* The editor/visualization and input processing */
 #include "deps/csr.h"     /* Simple Software Renderer */
 #include "deps/vm.h"      /* Linear Algebra / Vector Math Library */
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-
-LMTYN_API u8 csr_init(csr_context *ctx, u32 width, u32 height)
-{
-    u32 memory_size = (u32)csr_memory_size((int)width, (int)height);
-    void *memory = (void *)malloc(memory_size);
-
-    if (!memory)
-    {
-        return 0;
-    }
-
-    if (!csr_init_model(ctx, memory, memory_size, (i32)width, (i32)height))
-    {
-        return 0;
-    }
-
-    return 1;
-}
-
 LMTYN_API void win32_lmtyn_editor_resize_framebuffer(lmtyn_editor *editor, i32 new_w, i32 new_h, BITMAPINFO *bmi, csr_context *ctx)
 {
     if (new_w <= 0 || new_h <= 0)
@@ -50,21 +33,196 @@ LMTYN_API void win32_lmtyn_editor_resize_framebuffer(lmtyn_editor *editor, i32 n
     /*       update sizes and regions in the lmtyn_editor loop */
     lmtyn_editor_regions_update(editor);
 
-    /* CSR Render Buffer */
+    /* The cached grid layer has the layout of the framebuffer */
+    if (editor->grid_cache)
+    {
+        unsigned long grid_cache_size = lmtyn_editor_grid_cache_size((u32)new_w, (u32)new_h);
+
+        free(editor->grid_cache);
+        lmtyn_editor_grid_cache_init(editor, malloc(grid_cache_size), grid_cache_size);
+    }
+
+    /* The draw lists have one bin per tile of the framebuffer */
+    if (editor->draw_jobs)
+    {
+        unsigned long draw_lists_size = lmtyn_editor_draw_lists_size((u32)new_w, (u32)new_h);
+
+        free(editor->draw_jobs);
+        lmtyn_editor_draw_lists_init(editor, malloc(draw_lists_size), draw_lists_size);
+    }
+
+    /* CSR Render Buffer, only the zbuffer is needed since csr renders directly into the editor framebuffer */
+    /* 16 bit depth is plenty of precision for the preview and halves the depth bandwidth                   */
+    /* The visibility buffer behind it enables picking in the 3D view                                       */
     {
         u32 memory_size;
         void *memory;
 
-        if (ctx->framebuffer || ctx->zbuffer)
+        if (ctx->memory)
         {
-            free(ctx->framebuffer);
+            free(ctx->memory);
         }
 
-        memory_size = (u32)csr_memory_size((i32)new_w, (i32)new_h);
+        memory_size = (u32)((csr_memory_size_xrgb((i32)new_w, (i32)new_h, CSR_DEPTH_U16) + 3) & ~3UL) +
+                      (u32)csr_visibility_buffer_size((i32)new_w, (i32)new_h);
         memory = (void *)malloc(memory_size);
 
-        csr_init_model(ctx, memory, memory_size, (i32)new_w, (i32)new_h);
+        csr_init_model_xrgb(ctx, memory, memory_size, editor->framebuffer, (i32)new_w, (i32)new_w, (i32)new_h, CSR_DEPTH_U16);
+    }
+}
+
+/* Worker threads of lmtyn_editor_render, the calling thread takes jobs as well */
+#define WIN32_LMTYN_EDITOR_WORKERS 3
+
+typedef struct win32_lmtyn_editor_jobs
+{
+    HANDLE threads[WIN32_LMTYN_EDITOR_WORKERS];
+    HANDLE wake; /* semaphore, released once for every worker taking part in a batch */
+    HANDLE done; /* set by the last worker leaving the batch */
+
+    lmtyn_editor_job job;
+    void **job_data;
+    LONG job_count;
+    volatile LONG job_next;
+    volatile LONG workers_pending;
+
+} win32_lmtyn_editor_jobs;
+
+LMTYN_API void win32_lmtyn_editor_jobs_take(win32_lmtyn_editor_jobs *jobs)
+{
+    LONG index;
+
+    while ((index = InterlockedIncrement(&jobs->job_next) - 1) < jobs->job_count)
+    {
+        jobs->job(jobs->job_data[index]);
+    }
+}
+
+DWORD WINAPI win32_lmtyn_editor_jobs_worker(LPVOID parameter)
+{
+    win32_lmtyn_editor_jobs *jobs = (win32_lmtyn_editor_jobs *)parameter;
+
+    for (;;)
+    {
+        WaitForSingleObject(jobs->wake, INFINITE);
+
+        win32_lmtyn_editor_jobs_take(jobs);
+
+        if (InterlockedDecrement(&jobs->workers_pending) == 0)
+        {
+            SetEvent(jobs->done);
+        }
+    }
+}
+
+LMTYN_API void win32_lmtyn_editor_jobs_run(void *jobs_context, lmtyn_editor_job job, void **job_data, u32 job_count)
+{
+    win32_lmtyn_editor_jobs *jobs = (win32_lmtyn_editor_jobs *)jobs_context;
+    LONG workers = (LONG)job_count - 1;
+
+    workers = workers > WIN32_LMTYN_EDITOR_WORKERS ? WIN32_LMTYN_EDITOR_WORKERS : workers;
+
+    jobs->job = job;
+    jobs->job_data = job_data;
+    jobs->job_count = (LONG)job_count;
+    jobs->job_next = 0;
+    jobs->workers_pending = workers;
+
+    if (workers > 0)
+    {
+        ReleaseSemaphore(jobs->wake, workers, 0);
+    }
+
+    win32_lmtyn_editor_jobs_take(jobs);
+
+    /* No worker may still look at this batch once the job data goes out of scope */
+    if (workers > 0)
+    {
+        WaitForSingleObject(jobs->done, INFINITE);
+    }
+}
+
+LMTYN_API u8 win32_lmtyn_editor_jobs_initialize(win32_lmtyn_editor_jobs *jobs)
+{
+    u32 i;
+
+    jobs->wake = CreateSemaphoreA(0, 0, WIN32_LMTYN_EDITOR_WORKERS, 0);
+    jobs->done = CreateEventA(0, FALSE, FALSE, 0);
+
+    if (!jobs->wake || !jobs->done)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < WIN32_LMTYN_EDITOR_WORKERS; ++i)
+    {
+        jobs->threads[i] = CreateThread(0, 0, win32_lmtyn_editor_jobs_worker, jobs, 0, 0);
+
+        if (!jobs->threads[i])
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Thread generating the mesh of lmtyn_editor_mesh_worker */
+typedef struct win32_lmtyn_editor_mesh_thread
+{
+    HANDLE thread;
+    HANDLE wake; /* auto-reset event, set by the editor after posting circles or taking a mesh */
+    DWORD main_thread_id;
+    lmtyn_editor_mesh_worker *worker;
+
+} win32_lmtyn_editor_mesh_thread;
+
+LMTYN_API void win32_lmtyn_editor_mesh_thread_wake(void *wake_context)
+{
+    SetEvent(((win32_lmtyn_editor_mesh_thread *)wake_context)->wake);
+}
+
+DWORD WINAPI win32_lmtyn_editor_mesh_thread_main(LPVOID parameter)
+{
+    win32_lmtyn_editor_mesh_thread *mesh_thread = (win32_lmtyn_editor_mesh_thread *)parameter;
+
+    for (;;)
+    {
+        WaitForSingleObject(mesh_thread->wake, INFINITE);
+
+        while (lmtyn_editor_mesh_worker_process(mesh_thread->worker))
+        {
+            /* Wake the main loop from WaitMessage so the editor takes the new mesh */
+            PostThreadMessageA(mesh_thread->main_thread_id, WM_NULL, 0, 0);
+        }
+    }
+}
+
+LMTYN_API u8 win32_lmtyn_editor_mesh_thread_initialize(win32_lmtyn_editor_mesh_thread *mesh_thread, lmtyn_editor *editor)
+{
+    unsigned long memory_size = lmtyn_editor_mesh_worker_size(editor);
+
+    if (!lmtyn_editor_mesh_worker_init(editor, malloc(memory_size), memory_size))
+    {
+        return 0;
+    }
+
+    mesh_thread->worker = editor->mesh_worker;
+    mesh_thread->main_thread_id = GetCurrentThreadId();
+    mesh_thread->wake = CreateEventA(0, FALSE, FALSE, 0);
+    mesh_thread->thread = mesh_thread->wake ? CreateThread(0, 0, win32_lmtyn_editor_mesh_thread_main, mesh_thread, 0, 0) : 0;
+
+    /* Without the thread the editor generates the mesh itself */
+    if (!mesh_thread->thread)
+    {
+        editor->mesh_worker = 0;
+        return 0;
     }
+
+    editor->mesh_worker->wake = win32_lmtyn_editor_mesh_thread_wake;
+    editor->mesh_worker->wake_context = mesh_thread;
+
+    return 1;
 }
 
 typedef struct win32_lmtyn_editor_state
@@ -84,6 +242,25 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
     {
     case WM_ERASEBKGND:
         return 1;
+    case WM_PAINT:
+    {
+        /* Uncovered window areas are presented from the retained framebuffer */
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hWnd, &ps);
+        lmtyn_editor *editor = win32_state->editor;
+
+        if (editor->framebuffer)
+        {
+            StretchDIBits(
+                hdc,
+                0, 0, editor->framebuffer_width, editor->framebuffer_height,
+                0, 0, editor->framebuffer_width, editor->framebuffer_height,
+                editor->framebuffer, win32_state->bmi, DIB_RGB_COLORS, SRCCOPY);
+        }
+
+        EndPaint(hWnd, &ps);
+        return 0;
+    }
     case WM_CREATE:
     {
         CREATESTRUCTA *cs = (CREATESTRUCTA *)lParam;
@@ -222,6 +399,8 @@ i32 WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmd, i32 nShow)
     mesh.indices_capacity = sizeof(u32) * 4096;
     mesh.vertices = (f32 *)malloc(sizeof(f32) * mesh.vertices_capacity);
     mesh.indices = (u32 *)malloc(sizeof(u32) * mesh.indices_capacity);
+    mesh.edges_capacity = sizeof(u32) * 4096;
+    mesh.edges = (u32 *)malloc(sizeof(u32) * mesh.edges_capacity);
 
     win32_lmtyn_editor_resize_framebuffer(&editor, width, height, &bmi, &ctx);
 
@@ -234,6 +413,46 @@ i32 WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmd, i32 nShow)
         CIRCLES_CAPACITY,
         &mesh);
 
+    /* Keep the background and grid of the 2D views instead of redrawing them every frame */
+    lmtyn_editor_grid_cache_init(
+        &editor,
+        malloc(lmtyn_editor_grid_cache_size(width, height)),
+        lmtyn_editor_grid_cache_size(width, height));
+
+    /* Project every mesh vertex once per 2D view instead of once per edge */
+    lmtyn_editor_projection_init(
+        &editor,
+        malloc(lmtyn_editor_projection_size(mesh.vertices_capacity / 3)),
+        lmtyn_editor_projection_size(mesh.vertices_capacity / 3));
+
+    /* Cull the circles outside of the 2D views by the bounds of runs of circles */
+    lmtyn_editor_circle_index_init(
+        &editor,
+        malloc(lmtyn_editor_circle_index_size(CIRCLES_CAPACITY)),
+        lmtyn_editor_circle_index_size(CIRCLES_CAPACITY));
+
+    /* Record the 2D views and draw them tile by tile, the rows of tiles run on the worker threads */
+    lmtyn_editor_draw_lists_init(
+        &editor,
+        malloc(lmtyn_editor_draw_lists_size(width, height)),
+        lmtyn_editor_draw_lists_size(width, height));
+
+    /* Trade 3D preview resolution for frame time while editing large models */
+    editor.render_scale_adaptive = 1;
+
+    /* Draw the XZ, YZ, XY and 3D views on worker threads, the editor draws them one after another otherwise */
+    win32_lmtyn_editor_jobs jobs = {0};
+
+    if (win32_lmtyn_editor_jobs_initialize(&jobs))
+    {
+        editor.jobs_run = win32_lmtyn_editor_jobs_run;
+        editor.jobs_context = &jobs;
+    }
+
+    /* Generate the mesh on its own thread, the views keep showing the last mesh until the next one is done */
+    win32_lmtyn_editor_mesh_thread mesh_thread = {0};
+    win32_lmtyn_editor_mesh_thread_initialize(&mesh_thread, &editor);
+
     win32_lmtyn_editor_state state = {0};
     state.editor = &editor;
     state.input = &editor_input;
@@ -281,6 +500,7 @@ i32 WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmd, i32 nShow)
     HDC hdc = GetDC(hwnd);
 
     u32 frame;
+    u32 i;
 
     for (;;)
     {
@@ -300,13 +520,27 @@ i32 WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrev, LPSTR lpCmd, i32 nShow)
             &editor_input,
             &ctx);
 
-        StretchDIBits(
-            hdc,
-            0, 0, editor.framebuffer_width, editor.framebuffer_height,
-            0, 0, editor.framebuffer_width, editor.framebuffer_height,
-            editor.framebuffer, &bmi, DIB_RGB_COLORS, SRCCOPY);
+        /* Only present the regions the editor redrew, the source y of a top-down DIB counts from the bottom */
+        for (i = 0; i < editor.dirty_rects_count; ++i)
+        {
+            lmtyn_editor_rect *rect = &editor.dirty_rects[i];
+
+            StretchDIBits(
+                hdc,
+                rect->x, rect->y, rect->w, rect->h,
+                rect->x, editor.framebuffer_height - rect->y - rect->h, rect->w, rect->h,
+                editor.framebuffer, &bmi, DIB_RGB_COLORS, SRCCOPY);
+        }
 
-        Sleep(1);
+        /* Nothing changed, sleep until the next input instead of polling */
+        if (editor.dirty_rects_count == 0)
+        {
+            WaitMessage();
+        }
+        else
+        {
+            Sleep(1);
+        }
 
         frame++;
     }